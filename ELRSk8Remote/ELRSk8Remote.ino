@@ -2,6 +2,10 @@
 #include "crsf.h"
 #include "led.h"
 #include "oledScreen.h"
+#include "frameScheduler.h"
+#include "throttleFilter.h"
+#include "throttleCurve.h"
+#include "latencyProfile.h"
 
 //ELRSk8 Remote - the Express LRS skateboard remote.
 //Developed By Aleksei Abramenko.
@@ -16,6 +20,7 @@
 //CONFIG////////////////////////////
 
 //#define CALIBRATION
+//#define OLED_SCREEN_DEMO   //cycles all screen pages with made up telemetry, prints bus stats and a PBM image of every page over Serial
 
 //#define STM32F103C8
 #define XIAOR4M1
@@ -72,11 +77,24 @@
   float batteryADCHigh = 10460.0f;
 #endif
 
-int throttleSamples = 1;    //YOU CAN TRY MULTISAMPLING FOR THROTTLE INPUT IF YOU THINK IT'S TOO NOISY
+int throttleFilterMode = THROTTLE_FILTER_MEDIAN; //TRY ANOTHER FILTER IF THROTTLE INPUT IS TOO NOISY: 0 - none / 1 - moving average / 2 - median / 3 - one euro
+const uint32_t throttleSampleIntervalUs = 1000;  //throttle ADC is sampled in the background at this rate, independent of the packet rate
 
-int ELRSpacketRate = 3;     // 0 - 50Hz / 1 - 100Hz Full / 2- 150Hz / 3 - 250Hz / 4 - 333Hz Full / 5 - 500Hz
+//THROTTLE CURVES, all in percent: expo 0 - linear .. 100 - cubic / deadband around throttleMid / how far full brake goes
+ThrottleCurveConfig throttleCurveConfig = {
+  0,   //throttle expo
+  0,   //brake expo
+  0,   //deadband
+  100, //max brake
+};
+
+int ELRSpacketRate = 3;     // 0 - 50Hz / 1 - 100Hz Full / 2- 150Hz / 3 - 250Hz / 4 - 333Hz Full / 5 - 500Hz / 6 - D250 / 7 - D500 / 8 - F500 / 9 - F1000
+                            // channel frame interval follows this setting, see crsfFrameIntervalUs()
 int ELRSpower = 0;          // 0 - 10mW / 1 - 25mW / 2 - 50mW /3 - 100mW
+bool ELRSsyncTiming = false; // follow the TX module timing sync frames (phase locks channel frames to the air packets)
 int ELRStelemetryRate = 4;  // 0 - Std / 1 - Off / 2 - 1:128 / 3 - 1:64 / 4 - 1:32 / 5 - 1:16 / 6 - 1:8 / 7 - 1:4 / 8 - 1:2 / 9 - Race
+                            // MUST MATCH THE RECEIVER: ELRSpacketRateHz / ELRStelemetryRatio in ELRSk8VescTelemetryReceiver.ino pace its telemetry,
+                            // it can't read them off the link, change both sketches together
 
 #define KILOMETERS
 //#define MILES
@@ -88,14 +106,49 @@ CRSF crsf;
 uint8_t crsfPacket[CRSF_PACKET_SIZE];
 uint8_t crsfCmdPacket[CRSF_CMD_PACKET_SIZE];
 int16_t rcChannels[CRSF_MAX_CHANNEL];
-unsigned long crsfTime = 0;
+FrameScheduler frameScheduler;
+ThrottleFilter throttleFilter;
+ThrottleCurve throttleCurve;
+const unsigned long throttleAdcGuardUs = 100;      //no ADC conversion started this close to a frame
+const int throttleCalibrationTolerance = 1 << (ADCResolution - 8); //CALIBRATION rebuilds the curve only when low/mid/high moved more than 1/256 of the ADC range
+const unsigned long housekeepingIntervalUs = 4000; //LED + remote battery tick, independent of the packet rate
+unsigned long housekeepingMicros = 0;
+const unsigned long oledBudgetMarginUs = 100;      //kept free before a frame for pumpTx/handleSerialIn
+unsigned long oledUpdateMillis = 0;
+const unsigned long oledMaxStarveMs = 50;          //at very high packet rates let the screen delay a frame at most this often
+const unsigned long telemetryStaleMs = 5000;       //telemetry older than this counts as lost (1:128 at 50Hz still sends every ~2.5s)
 unsigned long loopCount = 0;
 unsigned long currentMillis = 0;
-float throttle = 0;
+int16_t throttlePermille = 0;     //-1000 full brake .. 1000 full throttle, for the LED
 float remoteBatteryPercent = 0;
-float animationTime = 0;
+uint16_t animationPhase = 0;
 OledScreenMenu oledScreen;
 
+#ifdef LATENCY_PROFILE
+//STAGES OF ONE CHANNEL FRAME: ADC sample -> mapped -> packed -> CRC -> first byte to UART -> last byte to UART
+enum LatencyStages{
+  LATENCY_SAMPLE_TO_MAP,
+  LATENCY_MAP_TO_PACK,
+  LATENCY_PACK_TO_CRC,
+  LATENCY_CRC_TO_WRITE,
+  LATENCY_WRITE,
+  LATENCY_TOTAL,
+  LATENCY_STAGE_COUNT,
+};
+LatencyStats latencyStats[LATENCY_STAGE_COUNT];
+uint32_t latencySampleMicros = 0;
+uint32_t latencyMappedMicros = 0;
+uint32_t latencyFrames = 0;
+bool latencyPending = false;
+#endif
+
+void UpdateThrottleCurve() {
+  //REBUILD ONLY WHEN THE CALIBRATION CHANGED
+  if(!throttleCurve.Matches(throttleLow, throttleMid, throttleHigh)) {
+    throttleCurve.Build(throttleLow, throttleMid, throttleHigh, CRSFMin, CRSFMid, CRSFMax, throttleCurveConfig);
+  }
+}
+
 void setup()
 {
   analogReadResolution(ADCResolution);
@@ -103,6 +156,9 @@ void setup()
   pinMode(VOLTAGE_READ_PIN, INPUT);
   //TURN OFF LED TO SAVE POWER
   digitalWrite(LED_BUILTIN, HIGH); //INVERTED ON STM32f103
+
+  //THROTTLE
+  throttleFilter.Setup(throttleFilterMode, throttleSampleIntervalUs, analogRead(THROTTLE_PIN));
   
   //OLED
   int screenMode = SCREEN_VOLTAGE_DISTANCE;
@@ -117,9 +173,7 @@ void setup()
   oledScreen.Setup(MENU_BUTTON1_PIN, screenMode, useKilometers);
   
   //DRAW SCREEN
-  for (uint8_t i = 0; i < screenTextWidth * screenTextHeight; i++) {
-    oledScreen.Update();
-  }
+  oledScreen.Flush();
 
   //LED
   SetupLED(RGBLED_PIN);
@@ -133,7 +187,8 @@ void setup()
   delay(100);
   CRSFSerial.begin(CRSF_SERIAL_BAUDRATE);
   crsf.begin(CRSFSerial);
-  crsfTime = micros();
+  frameScheduler.Setup(crsfFrameIntervalUs(ELRSpacketRate));
+  crsf.setFrameInterval(frameScheduler.Interval());
   
   //DEBUG
   Serial.begin(115200);
@@ -143,6 +198,7 @@ void setup()
     throttleLow = throttleMid;
     throttleHigh = throttleMid;
   #endif
+  UpdateThrottleCurve();
 }
 
 float SampleThrottle(int samples) {
@@ -169,34 +225,24 @@ float lerp(float a, float b, float x)
   return a + x * (b - a);
 }
 
-float clamp(float x, float xMin, float xMax)
-{ 
-  if(x < xMin) {
-    return xMin;
-  }
-  if(x > xMax) {
-    return xMax;
-  }
-  return x;
-}
-
 
 
 bool CRSFUpdate() {
   unsigned long currentMicros = micros();
+  if (ELRSsyncTiming && crsf._syncUpdated) {
+    frameScheduler.Sync(crsf._syncIntervalUs, crsf._syncOffsetUs);
+    crsf.setFrameInterval(frameScheduler.Interval());
+    crsf._syncUpdated = false;
+  }
+
   //INPUT+CRSF - 635us
-  if (currentMicros - crsfTime > CRSF_TIME_BETWEEN_FRAMES_US) {
-    //Serial.println(currentMicros - crsfTime); //PERFORMANCE CHECK, should be close to 4000 usec
+  if (frameScheduler.Due(currentMicros)) {
     //THROTTLE INPUT
-    float potInput = SampleThrottle(throttleSamples);
+    //LATEST FILTERED SAMPLE, the ADC is read in the background from loop()
+    int potInput = throttleFilter.Value();
     
-    int CRSFThrottle = CRSFMid;
-    if(potInput < throttleMid) {
-      CRSFThrottle = round(mapfloat(potInput, throttleLow, throttleMid, CRSFMin, CRSFMid));
-    }
-    else {
-      CRSFThrottle = round(mapfloat(potInput, throttleMid, throttleHigh, CRSFMid, CRSFMax));
-    }
+    //CURVE TABLE BUILT FROM THE CALIBRATION
+    int CRSFThrottle = throttleCurve.Map(potInput);
 
     #ifdef CALIBRATION
       rcChannels[AILERON] = CRSFMid; //DO NOT SEND THROTTLE COMMANDS DURING CALIBRATION
@@ -204,7 +250,11 @@ bool CRSFUpdate() {
       rcChannels[AILERON] = CRSFThrottle;
     #endif
     
-    throttle =  mapfloat(potInput, throttleLow, throttleHigh, -1.0f, 1.0f);
+    throttlePermille = constrain(map(potInput, throttleLow, throttleHigh, -1000, 1000), -1000, 1000);
+    #ifdef LATENCY_PROFILE
+      latencySampleMicros = throttleFilter.SampleMicros();
+      latencyMappedMicros = micros();
+    #endif
     
 
     //SEND
@@ -230,9 +280,11 @@ bool CRSFUpdate() {
         //SEND CHANNELS
         crsf.crsfPrepareDataPacket(crsfPacket, rcChannels);
         crsf.CrsfWritePacket(crsfPacket, CRSF_PACKET_SIZE);
+        #ifdef LATENCY_PROFILE
+          latencyPending = true;
+        #endif
     }
 
-    crsfTime = currentMicros;
     return true;
   }
   //Serial.println((micros() - currentMicros));
@@ -254,40 +306,258 @@ void UpdateLed() {
   if(loopCount < 400)
   {
     //BLINK ON START
-    LEDColorRGB.r = lerp(255, 0, remoteBatteryPercent);
-    LEDColorRGB.g = lerp(0, 255, remoteBatteryPercent);
+    uint16_t batteryLevel = constrain((int)(remoteBatteryPercent * 256), 0, 256);
+    LEDColorRGB.r = LedLerp(255, 0, batteryLevel);
+    LEDColorRGB.g = LedLerp(0, 255, batteryLevel);
     LEDColorRGB.b = 0;
     blinkLED(100);
   }
   else {
-    if(throttle > - 0.1f) {
+    if(throttlePermille > -100) {
       //IDLE FLASH WHITE
-      animationTime += 0.01f;
-      float anim = clamp(sin(animationTime) * 4 - 3, 0, 1);
-      LEDColorRGB.r = lerp(0, 30, anim);
-      LEDColorRGB.g = lerp(0, 40, anim);
-      LEDColorRGB.b = lerp(0, 30, anim);
+      animationPhase += ledIdlePhaseStep;
+      uint16_t anim = LedIdlePulse(animationPhase);
+      LEDColorRGB.r = LedLerp(0, 30, anim);
+      LEDColorRGB.g = LedLerp(0, 40, anim);
+      LEDColorRGB.b = LedLerp(0, 30, anim);
       
       LightLed();
     }
     else {
       //BRAKING FLASH RED
-      animationTime += (0.005f - 0.015f * throttle) * 4;
-      float anim = sin(animationTime) * 0.5f + 0.5f;
-      LEDColorRGB.r = lerp(0, 255, anim);
+      animationPhase += LedBrakePhaseStep(throttlePermille);
+      uint16_t anim = LedBrakePulse(animationPhase);
+      LEDColorRGB.r = LedLerp(0, 255, anim);
       LEDColorRGB.g = 0;
       LEDColorRGB.b = 0;
       LightLed();
     }
   }
+}
+
+void SetScreenValues() {
+  //SEND TELEMETRY VALUES TO SCREEN, from a consistent snapshot
+  crsfTelemetry_t telemetry;
+  crsf._telemetry.snapshot(telemetry);
+
+  unsigned long now = millis();
+  if(telemetry.isFresh(CRSF_TELEMETRY_RIDE, telemetryStaleMs, now)) {
+    const crsf_elrsk8_ride_t &ride = telemetry.ride;
+    oledScreen.voltage = ride.cellVoltage;
+    oledScreen.distance = (ride.distance + 5) / 10;
+    oledScreen.speed = ride.speed * 100;
+    oledScreen.current = ride.current;
+    oledScreen.tempEsc = ride.tempEsc;
+    oledScreen.tempMotor = ride.tempMotor;
+    oledScreen.wattHours = ride.wattHours;
+  }
+  else if(telemetry.isFresh(CRSF_TELEMETRY_BATTERY, telemetryStaleMs, now)) {
+    //OLDER RECEIVER, only the battery frame with its own scaling
+    oledScreen.voltage = telemetry.battery.voltage;
+    oledScreen.distance = telemetry.battery.capacity;
+    oledScreen.speed = telemetry.battery.current;
+    oledScreen.current = telemetry.battery.remaining * 2; //sent as A * 5, 0.2A steps
+  }
+  //NEITHER FRESH: ride frames stopped (link lost), keep the last values rather than an old battery frame in the wrong scaling
+  //RIDE MAXIMUMS, kept by the remote since power on
+  oledScreen.maxSpeed = max(oledScreen.maxSpeed, oledScreen.speed);
+  oledScreen.maxCurrent = max(oledScreen.maxCurrent, oledScreen.current);
+
+  //SLOWER FRAMES FROM THE RECEIVER, layout in its crsfTelemetry.h, kept until the next one arrives
+  if(telemetry.isFresh(CRSF_TELEMETRY_GPS, telemetryStaleMs, now)) {
+    //THE RECEIVER SEES EVERY VESC SAMPLE, its maximums catch peaks the battery frames skip
+    oledScreen.maxSpeed = max(oledScreen.maxSpeed, (int32_t)telemetry.gps.groundspeed * 100);
+    oledScreen.maxCurrent = max(oledScreen.maxCurrent, (int32_t)telemetry.gps.heading);
+  }
+  if(telemetry.isFresh(CRSF_TELEMETRY_BARO, telemetryStaleMs, now)) {
+    oledScreen.whPerDistance = telemetry.baro.altitude;
+  }
+  
+  //oledScreen.linkQuality = telemetry.link.uplink_Link_quality;
+  //oledScreen.rssi = telemetry.link.uplink_RSSI_1;
+  if(telemetry.isFresh(CRSF_TELEMETRY_LINK, telemetryStaleMs, millis())) {
+    oledScreen.linkQuality = telemetry.link.downlink_Link_quality;
+    oledScreen.rssi = telemetry.link.downlink_RSSI;
+  }
+  else {
+    //NO LINK STATISTICS FOR A WHILE, DON'T KEEP SHOWING THE LAST GOOD VALUES
+    oledScreen.linkQuality = 0;
+    oledScreen.rssi = 0;
+  }
+
+}
+
+void UpdateScreen() {
+  //SEND SCREEN TILES IN THE TIME LEFT BEFORE THE NEXT FRAME
+  unsigned long budget = frameScheduler.TimeToNextFrame(micros());
+  budget = budget > oledBudgetMarginUs ? budget - oledBudgetMarginUs : 0;
+  int sent = oledScreen.Update(budget);
+
+  if(sent > 0 || !oledScreen.display.Busy()) {
+    oledUpdateMillis = millis();
+  }
+  else if(millis() - oledUpdateMillis > oledMaxStarveMs) {
+    //NEVER STARVE IT COMPLETELY (at F1000 a tile barely fits), push one tile anyway
+    oledScreen.display.ServiceOne();
+    oledUpdateMillis = millis();
+  }
+}
+
+#ifdef OLED_SCREEN_DEMO
+const unsigned long screenDemoPageMs = 3000;
+const unsigned long screenDemoStepMs = 250;
+unsigned long screenDemoPageMillis = 0;
+unsigned long screenDemoStepMillis = 0;
+bool screenDemoDumped = false;
+
+void ScreenDemo() {
+  unsigned long t = millis();
+
+  //MADE UP RIDE, stepped a few times a second so every page gets to a full refresh in between,
+  //values sweep their whole range so every digit count and sign shows up
+  if(t - screenDemoStepMillis >= screenDemoStepMs) {
+    screenDemoStepMillis = t;
+    oledScreen.voltage = 3300 + (t / 7) % 900;
+    oledScreen.distance = t / 1000;
+    oledScreen.speed = (t * 7) % 45000;
+    oledScreen.current = (int32_t)((t / 3) % 1200) - 200;
+    oledScreen.tempEsc = 200 + (t / 50) % 700;
+    oledScreen.tempMotor = (int32_t)((t / 30) % 1300) - 100;
+    oledScreen.linkQuality = 100 - (t / 100) % 101;
+    oledScreen.rssi = -(int32_t)((t / 40) % 121);
+    oledScreen.maxSpeed = max(oledScreen.maxSpeed, oledScreen.speed);
+    oledScreen.maxCurrent = max(oledScreen.maxCurrent, oledScreen.current);
+    oledScreen.wattHours = t / 900;
+    oledScreen.whPerDistance = 50 + (t / 20) % 400;
+    oledScreen.remoteBatteryPercent = 100 - (t / 100) % 101;
+  }
+
+  //PICTURE OF EVERY PAGE ONCE IT'S FULLY ON THE SCREEN
+  if(!screenDemoDumped && !oledScreen.display.Busy()) {
+    oledScreen.display.DumpPbm(Serial);
+    screenDemoDumped = true;
+  }
 
-  if(animationTime > 10000.0f) {
-    animationTime = 0;
+  if(t - screenDemoPageMillis >= screenDemoPageMs) {
+    //CSV: page, full refresh max us, tiles sent, bus bytes, bus bytes/s, bus busy us
+    OledTileDriver &display = oledScreen.display;
+    unsigned long elapsed = t - screenDemoPageMillis;
+    Serial.print(oledScreen.Mode());
+    Serial.print(',');
+    Serial.print(display.maxRefreshUs);
+    Serial.print(',');
+    Serial.print(display.tilesSent);
+    Serial.print(',');
+    Serial.print(display.BusBytes());
+    Serial.print(',');
+    Serial.print(display.BusBytes() * 1000UL / elapsed);
+    Serial.print(',');
+    Serial.println(display.busMicros);
+
+    oledScreen.SetMode(oledScreen.Mode() >= SCREEN_MAX_MODES ? 0 : oledScreen.Mode() + 1);
+    display.ResetStats();
+    screenDemoPageMillis = t;
+    screenDemoDumped = false;
   }
 }
+#endif
+
+#ifdef LATENCY_PROFILE
+void RecordLatency() {
+  //ONCE THE LAST BYTE OF THE CHANNEL FRAME IS IN THE UART
+  const crsfLatencyStamps_t &stamps = crsf._latency;
+  if(!latencyPending || stamps.frames == latencyFrames) {
+    return;
+  }
+  latencyFrames = stamps.frames;
+  latencyPending = false;
+
+  latencyStats[LATENCY_SAMPLE_TO_MAP].Add(latencyMappedMicros - latencySampleMicros);
+  latencyStats[LATENCY_MAP_TO_PACK].Add(stamps.packed - latencyMappedMicros);
+  latencyStats[LATENCY_PACK_TO_CRC].Add(stamps.crcDone - stamps.packed);
+  latencyStats[LATENCY_CRC_TO_WRITE].Add(stamps.writeStart - stamps.crcDone);
+  latencyStats[LATENCY_WRITE].Add(stamps.writeDone - stamps.writeStart);
+  latencyStats[LATENCY_TOTAL].Add(stamps.writeDone - latencySampleMicros);
+}
+
+void PrintLatency() {
+  //CSV: "lat", then min,avg,max,p99 us for sample->map, map->pack, pack->crc, crc->write start, write, sample->write done
+  Serial.print("lat");
+  for(int i = 0;i < LATENCY_STAGE_COUNT;++i) {
+    Serial.print(',');
+    latencyStats[i].PrintCsv(Serial);
+  }
+  Serial.println();
+}
+#endif
 
 unsigned long measureMicros = micros();
 int packetsPerSecond = 0;
+
+#ifdef CRSF_PROFILE
+void PrintProfile() {
+  //CSV: packets/s, frame lateness p50/p99/max us, missed frames, rx calls, rx bytes, rx frames, crc errors, rx ns/byte, rx max call us, tx avg prepare us, tx max prepare us,
+  //     rx dropped bytes, rx deferred bytes, telemetry age us, oled tiles sent, oled tiles unchanged, oled tile us, oled us saved,
+  //     led shows, led skipped shows, led show us, ride deltas dropped
+  const crsfProfile_t &p = crsf._profile;
+  Serial.print(packetsPerSecond);
+  Serial.print(',');
+  Serial.print(frameScheduler.LatenessPercentile(50));
+  Serial.print(',');
+  Serial.print(frameScheduler.LatenessPercentile(99));
+  Serial.print(',');
+  Serial.print(frameScheduler.maxLateness);
+  Serial.print(',');
+  Serial.print(frameScheduler.missedFrames);
+  Serial.print(',');
+  Serial.print(p.rxCalls);
+  Serial.print(',');
+  Serial.print(p.rxBytes);
+  Serial.print(',');
+  Serial.print(p.rxFrames);
+  Serial.print(',');
+  Serial.print(p.rxCrcErrors);
+  Serial.print(',');
+  Serial.print(p.rxBytes ? (p.rxMicros * 1000UL) / p.rxBytes : 0UL);
+  Serial.print(',');
+  Serial.print(p.rxMaxCallMicros);
+  Serial.print(',');
+  Serial.print(p.txPackets ? p.txPrepareMicros / p.txPackets : 0UL);
+  Serial.print(',');
+  Serial.print(p.txMaxPrepareMicros);
+  Serial.print(',');
+  Serial.print(crsf._rxStats.droppedBytes);
+  Serial.print(',');
+  Serial.print(crsf._rxStats.deferredBytes);
+  Serial.print(',');
+  Serial.print(micros() - crsf._lastFrameMicros);
+  Serial.print(',');
+  Serial.print(oledScreen.display.tilesSent);
+  Serial.print(',');
+  Serial.print(oledScreen.display.tilesUnchanged);
+  Serial.print(',');
+  Serial.print(oledScreen.display.tileCostUs);
+  Serial.print(',');
+  Serial.print(oledScreen.display.tilesUnchanged * oledScreen.display.tileCostUs);
+  Serial.print(',');
+  Serial.print(ledShows);
+  Serial.print(',');
+  Serial.print(ledShowsSkipped);
+  Serial.print(',');
+  Serial.print(ledBlockedMicros);
+  Serial.print(',');
+  Serial.println(crsf._rxStats.rideDeltasDropped);
+
+  crsf.resetProfile();
+  frameScheduler.ResetStats();
+  oledScreen.display.tilesSent = 0;
+  oledScreen.display.tilesUnchanged = 0;
+  ledShows = 0;
+  ledShowsSkipped = 0;
+  ledBlockedMicros = 0;
+}
+#endif
+
 void loop()
 {
     bool crsfUpdated = CRSFUpdate();
@@ -298,40 +568,59 @@ void loop()
       if(micros() - measureMicros > 1000000) {
         //oledScreen.distance = ((float)packetsPerSecond) * 0.1f;
         //Serial.println(packetsPerSecond);
+        #ifdef CRSF_PROFILE
+          PrintProfile();
+        #endif
+        #ifdef LATENCY_PROFILE
+          PrintLatency();
+        #endif
         measureMicros = micros();
         packetsPerSecond = 0;
       }
     }
     
     
-    if(!crsfUpdated) {
-      //RECEIVE TELEMETRY
-      crsf.handleSerialIn();
+    //KEEP FEEDING QUEUED FRAMES TO THE UART
+    crsf.pumpTx();
+    #ifdef LATENCY_PROFILE
+      RecordLatency();
+    #endif
+
+    //RECEIVE TELEMETRY, drains the UART within CRSF_RX_BUDGET_US
+    crsf.handleSerialIn();
+
+    //THROTTLE ADC IN THE BACKGROUND, kept clear of the frame deadline so a conversion never delays a frame
+    if(frameScheduler.TimeToNextFrame(micros()) > throttleAdcGuardUs && throttleFilter.Due(micros())) {
+      throttleFilter.AddSample(analogRead(THROTTLE_PIN));
     }
-    else {
-      //DO SCREEN UPDATE ONCE AFTER CRSF UPDATE
+
+    //LED + BATTERY AT A FIXED RATE, SO ANIMATIONS AND FILTERING DON'T DEPEND ON THE PACKET RATE
+    if(micros() - housekeepingMicros >= housekeepingIntervalUs) {
+      housekeepingMicros = micros();
       MeasureRemoteBattery();
       UpdateLed();
-
-      //SEND TELEMETRY VALUES TO SCREEN
-      oledScreen.voltage = ((float)crsf._battery.voltage) * 0.001f;
-      oledScreen.distance = ((float)crsf._battery.capacity) * 0.1f;
-      oledScreen.speed = ((float)crsf._battery.current) * 0.001f;
-      oledScreen.current = ((float)crsf._battery.remaining) * 0.5f;
-      
-      //oledScreen.linkQuality = crsf._linkStatistics.uplink_Link_quality;
-      //oledScreen.rssi = crsf._linkStatistics.uplink_RSSI_1;
-      oledScreen.linkQuality = crsf._linkStatistics.downlink_Link_quality;
-      oledScreen.rssi = crsf._linkStatistics.downlink_RSSI;
-      oledScreen.Update();
     }
 
+    //SCREEN: new values once per frame, tiles go out whenever they fit before the next frame
+    #ifdef OLED_SCREEN_DEMO
+      ScreenDemo();
+    #else
+      if(crsfUpdated) {
+        SetScreenValues();
+      }
+    #endif
+    UpdateScreen();
+
 
     #ifdef CALIBRATION
       int potInput = analogRead(THROTTLE_PIN);
       throttleLow = min(throttleLow, potInput);
       throttleMid = potInput;
       throttleHigh = max(throttleHigh, potInput);
+      //MID FOLLOWS THE ADC NOISE EVERY PASS, the tables don't need to
+      if(!throttleCurve.Near(throttleLow, throttleMid, throttleHigh, throttleCalibrationTolerance)) {
+        UpdateThrottleCurve();
+      }
       int calibrateVoltage = analogRead(VOLTAGE_READ_PIN);
 
       oledScreen.throttleCalibrate = potInput;
@@ -0,0 +1,96 @@
+#ifndef CHANNELPACKER_H
+#define CHANNELPACKER_H
+
+#include <stdint.h>
+
+/*
+ * Packs NumChannels values of BitsPerChannel bits each, LSB first, the layout
+ * used by CRSF RC_CHANNELS_PACKED (16 x 11 bit) and SBUS.
+ *
+ * pack()   packs everything through a 64 bit accumulator, flushing 32 bits at a time.
+ * update() remembers the last values and only patches the bits of channels that changed,
+ *          returning the first payload byte that changed so the caller can restart its CRC there.
+ */
+template <uint8_t NumChannels, uint8_t BitsPerChannel>
+class ChannelPacker
+{
+    static_assert(BitsPerChannel > 0 && BitsPerChannel <= 24, "a channel has to fit in a 32 bit window");
+
+public:
+    static const uint8_t packedSize = (NumChannels * BitsPerChannel + 7) / 8;
+    static const uint32_t channelMask = (1UL << BitsPerChannel) - 1;
+
+    static void pack(uint8_t out[], const int16_t channels[])
+    {
+        uint64_t acc = 0;
+        uint8_t bits = 0;
+        uint8_t pos = 0;
+        for (uint8_t i = 0; i < NumChannels; i++)
+        {
+            acc |= (uint64_t)((uint32_t)channels[i] & channelMask) << bits;
+            bits += BitsPerChannel;
+            if (bits >= 32)
+            {
+                out[pos++] = (uint8_t)acc;
+                out[pos++] = (uint8_t)(acc >> 8);
+                out[pos++] = (uint8_t)(acc >> 16);
+                out[pos++] = (uint8_t)(acc >> 24);
+                acc >>= 32;
+                bits -= 32;
+            }
+        }
+        while (pos < packedSize)
+        {
+            out[pos++] = (uint8_t)acc;
+            acc >>= 8;
+        }
+    }
+
+    // Repack only the channels that changed since the last call.
+    // Returns the index of the first changed byte in out, or packedSize if nothing changed.
+    uint8_t update(uint8_t out[], const int16_t channels[])
+    {
+        if (!_valid)
+        {
+            pack(out, channels);
+            for (uint8_t i = 0; i < NumChannels; i++)
+                _last[i] = channels[i];
+            _valid = true;
+            return 0;
+        }
+
+        uint8_t firstChanged = packedSize;
+        for (uint8_t i = 0; i < NumChannels; i++)
+        {
+            if (channels[i] == _last[i])
+                continue;
+            _last[i] = channels[i];
+
+            uint16_t bitPos = (uint16_t)i * BitsPerChannel;
+            uint8_t first = bitPos / 8;
+            uint8_t shift = bitPos % 8;
+            uint8_t count = (shift + BitsPerChannel + 7) / 8;
+
+            uint32_t window = 0;
+            for (uint8_t b = 0; b < count; b++)
+                window |= (uint32_t)out[first + b] << (8 * b);
+            window &= ~(channelMask << shift);
+            window |= ((uint32_t)channels[i] & channelMask) << shift;
+            for (uint8_t b = 0; b < count; b++)
+                out[first + b] = (uint8_t)(window >> (8 * b));
+
+            if (first < firstChanged)
+                firstChanged = first;
+        }
+        return firstChanged;
+    }
+
+    // Force the next update() to do a full pack
+    void invalidate() { _valid = false; }
+
+private:
+    int16_t _last[NumChannels];
+    bool _valid = false;
+};
+
+#endif
@@ -0,0 +1,24 @@
+#include "crc8.h"
+
+constexpr Crc8Tables crsfCrc8Tables;
+
+// Spot check against the table from the CRSF protocol document rev7
+static_assert(crsfCrc8Tables.t[0][1] == 0xD5 && crsfCrc8Tables.t[0][0x80] == 0xEF && crsfCrc8Tables.t[0][255] == 0xF9,
+              "CRC8 table doesn't match the CRSF reference table");
+
+uint8_t crsf_crc8(const uint8_t *ptr, uint8_t len)
+{
+    uint8_t crc = 0;
+#if CRSF_CRC8_SLICES == 4
+    const uint8_t (*t)[256] = crsfCrc8Tables.t;
+    while (len >= 4)
+    {
+        crc = t[3][crc ^ ptr[0]] ^ t[2][ptr[1]] ^ t[1][ptr[2]] ^ t[0][ptr[3]];
+        ptr += 4;
+        len -= 4;
+    }
+#endif
+    while (len--)
+        crc = crsfCrc8Tables.t[0][crc ^ *ptr++];
+    return crc;
+}
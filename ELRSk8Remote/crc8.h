@@ -0,0 +1,57 @@
+#ifndef CRC8_H
+#define CRC8_H
+
+#include <stdint.h>
+
+/*
+ * CRC-8/DVB-S2 (poly 0xD5, init 0, no reflection) as used by CRSF.
+ *
+ * Tables are generated at compile time and live in flash (const), nothing is copied to RAM.
+ * CRSF_CRC8_SLICES selects the implementation:
+ *   1 - classic byte at a time lookup, 256 bytes of flash (default)
+ *   4 - slice-by-4, 4 bytes per step through 4 tables, 1 KB of flash
+ * The default is 1: received frames and the channel packet are checked byte by byte as they come in,
+ * crsf_crc8() only runs over the 6 byte command packet, too short for slicing to pay for 768 more bytes.
+ *
+ * There is no hardware path: the RA4M1 CRC calculator only does the 0x07 CRC-8 polynomial
+ * and the STM32F103 CRC unit is fixed CRC-32, neither can compute 0xD5.
+ */
+#ifndef CRSF_CRC8_SLICES
+#define CRSF_CRC8_SLICES 1
+#endif
+
+#define CRSF_CRC8_POLY 0xD5
+
+static_assert(CRSF_CRC8_SLICES == 1 || CRSF_CRC8_SLICES == 4, "CRSF_CRC8_SLICES must be 1 or 4");
+
+struct Crc8Tables
+{
+    uint8_t t[CRSF_CRC8_SLICES][256];
+
+    // t[0] is the usual table, t[k] runs t[0] k more times (the same byte followed by k zero bytes)
+    constexpr Crc8Tables() : t()
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            uint8_t crc = i;
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ CRSF_CRC8_POLY) : (uint8_t)(crc << 1);
+            t[0][i] = crc;
+        }
+        for (int k = 1; k < CRSF_CRC8_SLICES; k++)
+            for (int i = 0; i < 256; i++)
+                t[k][i] = t[0][t[k - 1][i]];
+    }
+};
+
+extern const Crc8Tables crsfCrc8Tables;
+
+// Feed one byte, for CRCs computed on the fly (ring buffer, incremental packing)
+static inline uint8_t crsf_crc8_byte(uint8_t crc, uint8_t b)
+{
+    return crsfCrc8Tables.t[0][crc ^ b];
+}
+
+uint8_t crsf_crc8(const uint8_t *ptr, uint8_t len);
+
+#endif
@@ -50,33 +50,6 @@
 #include "crsf.h"
 
 
-// crc implementation from CRSF protocol document rev7
-static uint8_t crsf_crc8tab[256] = {
-    0x00, 0xD5, 0x7F, 0xAA, 0xFE, 0x2B, 0x81, 0x54, 0x29, 0xFC, 0x56, 0x83, 0xD7, 0x02, 0xA8, 0x7D,
-    0x52, 0x87, 0x2D, 0xF8, 0xAC, 0x79, 0xD3, 0x06, 0x7B, 0xAE, 0x04, 0xD1, 0x85, 0x50, 0xFA, 0x2F,
-    0xA4, 0x71, 0xDB, 0x0E, 0x5A, 0x8F, 0x25, 0xF0, 0x8D, 0x58, 0xF2, 0x27, 0x73, 0xA6, 0x0C, 0xD9,
-    0xF6, 0x23, 0x89, 0x5C, 0x08, 0xDD, 0x77, 0xA2, 0xDF, 0x0A, 0xA0, 0x75, 0x21, 0xF4, 0x5E, 0x8B,
-    0x9D, 0x48, 0xE2, 0x37, 0x63, 0xB6, 0x1C, 0xC9, 0xB4, 0x61, 0xCB, 0x1E, 0x4A, 0x9F, 0x35, 0xE0,
-    0xCF, 0x1A, 0xB0, 0x65, 0x31, 0xE4, 0x4E, 0x9B, 0xE6, 0x33, 0x99, 0x4C, 0x18, 0xCD, 0x67, 0xB2,
-    0x39, 0xEC, 0x46, 0x93, 0xC7, 0x12, 0xB8, 0x6D, 0x10, 0xC5, 0x6F, 0xBA, 0xEE, 0x3B, 0x91, 0x44,
-    0x6B, 0xBE, 0x14, 0xC1, 0x95, 0x40, 0xEA, 0x3F, 0x42, 0x97, 0x3D, 0xE8, 0xBC, 0x69, 0xC3, 0x16,
-    0xEF, 0x3A, 0x90, 0x45, 0x11, 0xC4, 0x6E, 0xBB, 0xC6, 0x13, 0xB9, 0x6C, 0x38, 0xED, 0x47, 0x92,
-    0xBD, 0x68, 0xC2, 0x17, 0x43, 0x96, 0x3C, 0xE9, 0x94, 0x41, 0xEB, 0x3E, 0x6A, 0xBF, 0x15, 0xC0,
-    0x4B, 0x9E, 0x34, 0xE1, 0xB5, 0x60, 0xCA, 0x1F, 0x62, 0xB7, 0x1D, 0xC8, 0x9C, 0x49, 0xE3, 0x36,
-    0x19, 0xCC, 0x66, 0xB3, 0xE7, 0x32, 0x98, 0x4D, 0x30, 0xE5, 0x4F, 0x9A, 0xCE, 0x1B, 0xB1, 0x64,
-    0x72, 0xA7, 0x0D, 0xD8, 0x8C, 0x59, 0xF3, 0x26, 0x5B, 0x8E, 0x24, 0xF1, 0xA5, 0x70, 0xDA, 0x0F,
-    0x20, 0xF5, 0x5F, 0x8A, 0xDE, 0x0B, 0xA1, 0x74, 0x09, 0xDC, 0x76, 0xA3, 0xF7, 0x22, 0x88, 0x5D,
-    0xD6, 0x03, 0xA9, 0x7C, 0x28, 0xFD, 0x57, 0x82, 0xFF, 0x2A, 0x80, 0x55, 0x01, 0xD4, 0x7E, 0xAB,
-    0x84, 0x51, 0xFB, 0x2E, 0x7A, 0xAF, 0x05, 0xD0, 0xAD, 0x78, 0xD2, 0x07, 0x53, 0x86, 0x2C, 0xF9};
-
-uint8_t crsf_crc8(const uint8_t *ptr, uint8_t len) {
-    uint8_t crc = 0;
-    for (uint8_t i = 0; i < len; i++){
-        crc = crsf_crc8tab[crc ^ *ptr++];
-    }
-    return crc;
-}
-
 // Serial begin
 void CRSF::begin(Stream& _CRSFSerial) {
     CRSFSerial = &_CRSFSerial;
@@ -84,41 +57,48 @@ void CRSF::begin(Stream& _CRSFSerial) {
 
 // prepare data packet
 void CRSF::crsfPrepareDataPacket(uint8_t packet[], int16_t channels[]) {
+#ifdef CRSF_PROFILE
+    uint32_t startMicros = micros();
+#endif
 
-    // const uint8_t crc = crsf_crc8(&packet[2], CRSF_PACKET_SIZE-3);
     /*
      * Map 1000-2000 with middle at 1500 chanel values to
      * 173-1811 with middle at 992 S.BUS protocol requires
     */
 
     // packet[0] = UART_SYNC; //Header
-    packet[0] = ELRS_ADDRESS; // Header
-    packet[1] = 24;           // length of type (24) + payload + crc
-    packet[2] = TYPE_CHANNELS;
-    packet[3] = (uint8_t)(channels[0] & 0x07FF);
-    packet[4] = (uint8_t)((channels[0] & 0x07FF) >> 8 | (channels[1] & 0x07FF) << 3);
-    packet[5] = (uint8_t)((channels[1] & 0x07FF) >> 5 | (channels[2] & 0x07FF) << 6);
-    packet[6] = (uint8_t)((channels[2] & 0x07FF) >> 2);
-    packet[7] = (uint8_t)((channels[2] & 0x07FF) >> 10 | (channels[3] & 0x07FF) << 1);
-    packet[8] = (uint8_t)((channels[3] & 0x07FF) >> 7 | (channels[4] & 0x07FF) << 4);
-    packet[9] = (uint8_t)((channels[4] & 0x07FF) >> 4 | (channels[5] & 0x07FF) << 7);
-    packet[10] = (uint8_t)((channels[5] & 0x07FF) >> 1);
-    packet[11] = (uint8_t)((channels[5] & 0x07FF) >> 9 | (channels[6] & 0x07FF) << 2);
-    packet[12] = (uint8_t)((channels[6] & 0x07FF) >> 6 | (channels[7] & 0x07FF) << 5);
-    packet[13] = (uint8_t)((channels[7] & 0x07FF) >> 3);
-    packet[14] = (uint8_t)((channels[8] & 0x07FF));
-    packet[15] = (uint8_t)((channels[8] & 0x07FF) >> 8 | (channels[9] & 0x07FF) << 3);
-    packet[16] = (uint8_t)((channels[9] & 0x07FF) >> 5 | (channels[10] & 0x07FF) << 6);
-    packet[17] = (uint8_t)((channels[10] & 0x07FF) >> 2);
-    packet[18] = (uint8_t)((channels[10] & 0x07FF) >> 10 | (channels[11] & 0x07FF) << 1);
-    packet[19] = (uint8_t)((channels[11] & 0x07FF) >> 7 | (channels[12] & 0x07FF) << 4);
-    packet[20] = (uint8_t)((channels[12] & 0x07FF) >> 4 | (channels[13] & 0x07FF) << 7);
-    packet[21] = (uint8_t)((channels[13] & 0x07FF) >> 1);
-    packet[22] = (uint8_t)((channels[13] & 0x07FF) >> 9 | (channels[14] & 0x07FF) << 2);
-    packet[23] = (uint8_t)((channels[14] & 0x07FF) >> 6 | (channels[15] & 0x07FF) << 5);
-    packet[24] = (uint8_t)((channels[15] & 0x07FF) >> 3);
-
-    packet[25] = crsf_crc8(&packet[2], packet[1] - 1); // CRC
+    _dataPacket[0] = ELRS_ADDRESS; // Header
+    _dataPacket[1] = 24;           // length of type (24) + payload + crc
+    _dataPacket[2] = TYPE_CHANNELS;
+
+    // Only channels that changed are repacked, and the CRC restarts at the first changed byte.
+    // _crcState[k] is the CRC over the first k bytes of type + payload.
+    uint8_t firstChanged = _channelPacker.update(&_dataPacket[3], channels);
+#ifdef LATENCY_PROFILE
+    _latency.packed = micros();
+#endif
+    uint8_t crcLen = _dataPacket[1] - 1;
+    uint8_t crc = _crcState[firstChanged + 1];
+    for (uint8_t k = firstChanged + 1; k < crcLen; k++)
+    {
+        crc = crsf_crc8_byte(crc, _dataPacket[2 + k]);
+        _crcState[k + 1] = crc;
+    }
+    _dataPacket[25] = crc; // CRC
+
+    memcpy(packet, _dataPacket, CRSF_PACKET_SIZE);
+#ifdef LATENCY_PROFILE
+    _latency.crcDone = micros();
+    _latencyArmed = true;
+#endif
+
+#ifdef CRSF_PROFILE
+    uint32_t elapsed = micros() - startMicros;
+    _profile.txPackets++;
+    _profile.txPrepareMicros += elapsed;
+    if (elapsed > _profile.txMaxPrepareMicros)
+        _profile.txMaxPrepareMicros = elapsed;
+#endif
 }
 
 // prepare elrs setup packet (power, packet rate...)
@@ -133,8 +113,86 @@ void CRSF::crsfPrepareCmdPacket(uint8_t packetCmd[], uint8_t command, uint8_t va
     packetCmd[7] = crsf_crc8(&packetCmd[2], packetCmd[1] - 1); // CRC
 }
 
+// Queue a frame for sending and return right away, the UART TX interrupt does the actual work.
+// If a frame is already waiting behind the one being sent it gets replaced, newer channels win.
 void CRSF::CrsfWritePacket(uint8_t packet[], uint8_t packetLength) {
-    CRSFSerial->write(packet, packetLength);
+    if (packetLength > CRSF_FRAME_SIZE_MAX)
+        return;
+
+    uint8_t slot;
+    if (_txPending == 0) {
+        slot = _txSlot;
+        _txPos = 0;
+        _txStartMicros = micros();
+        _txPending = 1;
+    }
+    else {
+        slot = _txSlot ^ 1;
+        if (_txPending == 2)
+            _txStats.overruns++;
+        _txPending = 2;
+    }
+    memcpy(_txBuf[slot], packet, packetLength);
+    _txLen[slot] = packetLength;
+#ifdef LATENCY_PROFILE
+    if (_latencyArmed) {
+        _latencySlot = slot;
+        _latencyArmed = false;
+    }
+    else if (_latencySlot == slot) {
+        _latencySlot = 0xFF; // stamped frame got replaced by one that isn't a channel frame
+    }
+#endif
+
+    pumpTx();
+}
+
+// Hand queued bytes to the UART without blocking, only as many as its TX buffer has room for
+void CRSF::pumpTx() {
+    while (_txPending) {
+        uint8_t left = _txLen[_txSlot] - _txPos;
+        int room = CRSFSerial->availableForWrite();
+        if (room > 0) {
+            _txRoomReported = true;
+        }
+        else if (!_txRoomReported) {
+            // Core without availableForWrite() (Print's default returns 0), write it all right away like before
+            room = left;
+            _txStats.blockingWrites++;
+        }
+        else {
+            // UART reported space before, so it's just full: wait, unless it stalled for a whole frame interval
+            if (micros() - _txStartMicros < _frameIntervalUs)
+                return;
+            room = left;
+            _txStats.blockingWrites++;
+        }
+
+        uint8_t chunk = (uint8_t)min((int)left, room);
+#ifdef LATENCY_PROFILE
+        if (_txPos == 0 && _latencySlot == _txSlot)
+            _latency.writeStart = micros();
+#endif
+        CRSFSerial->write(&_txBuf[_txSlot][_txPos], chunk);
+        _txPos += chunk;
+        if (_txPos < _txLen[_txSlot])
+            return;
+
+#ifdef LATENCY_PROFILE
+        if (_latencySlot == _txSlot) {
+            _latency.writeDone = micros();
+            _latency.frames++;
+            _latencySlot = 0xFF;
+        }
+#endif
+
+        // Frame is in the UART buffer, move on to the next one
+        _txStats.frames++;
+        _txSlot ^= 1;
+        _txPos = 0;
+        _txStartMicros = micros();
+        _txPending--;
+    }
 }
 
 
@@ -142,83 +200,155 @@ void CRSF::CrsfWritePacket(uint8_t packet[], uint8_t packetLength) {
 
 CRSF::CRSF() :
     //_crc(0xd5),
-    _lastReceive(0), _lastChannelsPacket(0), _linkIsUp(false), CRSFSerial(0) {}
+    CRSFSerial(0), _rxHead(0), _rxTail(0), _syncIntervalUs(0), _syncOffsetUs(0), _syncUpdated(false), _rideKeySeq(0), _rideKeyValid(false), _frameIntervalUs(CRSF_TIME_BETWEEN_FRAMES_US), _rxBudgetUs(CRSF_RX_BUDGET_US), _lastFrameMicros(0),
+    _lastReceive(0), _lastChannelsPacket(0), _lastLinkMillis(0), _linkIsUp(false) {
+    memset(&_rxStats, 0, sizeof(_rxStats));
+    _crcState[0] = 0;
+    _crcState[1] = crsf_crc8_byte(0, TYPE_CHANNELS);
+    memset(&_txStats, 0, sizeof(_txStats));
+    _txSlot = 0;
+    _txPos = 0;
+    _txPending = 0;
+    _txRoomReported = false;
+#ifdef CRSF_PROFILE
+    resetProfile();
+#endif
+#ifdef LATENCY_PROFILE
+    memset(&_latency, 0, sizeof(_latency));
+    _latencyArmed = false;
+    _latencySlot = 0xFF;
+#endif
+}
+
+#ifdef CRSF_PROFILE
+void CRSF::resetProfile()
+{
+    memset(&_profile, 0, sizeof(_profile));
+}
+#endif
     
 
+// Frame interval follows the selected packet rate, the receive budget scales with it
+void CRSF::setFrameInterval(uint32_t intervalUs)
+{
+    _frameIntervalUs = intervalUs;
+    _rxBudgetUs = intervalUs / CRSF_RX_BUDGET_DIVIDER;
+}
+
+// Drain everything the UART has buffered, bounded by the receive time budget
 void CRSF::handleSerialIn()
 {
-    int maxPackets = 5;
-    while (CRSFSerial->available() && maxPackets > 0)
+    uint32_t startMicros = micros();
+    while (CRSFSerial->available())
     {
+        if (micros() - startMicros > _rxBudgetUs)
+        {
+            // Out of time, leave the rest for the next call
+            _rxStats.budgetHits++;
+            _rxStats.deferredBytes += CRSFSerial->available();
+            break;
+        }
+
         uint8_t b = CRSFSerial->read();
         _lastReceive = millis();
+#ifdef CRSF_PROFILE
+        _profile.rxBytes++;
+#endif
 
-        _rxBuf[_rxBufPos++] = b;
-        handleByteReceived();
-
-        if (_rxBufPos == (sizeof(_rxBuf)/sizeof(_rxBuf[0])))
+        if (rxRingCount() == CRSF_RX_RING_SIZE - 1)
         {
-            // Packet buffer filled and no valid packet found, dump the whole thing
-            _rxBufPos = 0;
+            // Ring full without a valid frame, drop the oldest byte
+            _rxHead = (_rxHead + 1) & CRSF_RX_RING_MASK;
+            _rxStats.droppedBytes++;
         }
-        --maxPackets;
+        _rxRing[_rxTail] = b;
+        _rxTail = (_rxTail + 1) & CRSF_RX_RING_MASK;
+        handleByteReceived();
     }
 
     checkPacketTimeout();
     checkLinkDown();
+
+#ifdef CRSF_PROFILE
+    uint32_t elapsed = micros() - startMicros;
+    _profile.rxCalls++;
+    _profile.rxMicros += elapsed;
+    if (elapsed > _profile.rxMaxCallMicros)
+        _profile.rxMaxCallMicros = elapsed;
+#endif
 }
 
+// A frame can only start with one of the addresses a TX module talks to the handset with
+static inline bool crsfIsFrameStart(uint8_t addr)
+{
+    return addr == CRSF_ADDRESS_RADIO_TRANSMITTER || addr == CRSF_SYNC_BYTE || addr == CRSF_ADDRESS_CRSF_TRANSMITTER;
+}
+
+// Sync state machine over the receive ring:
+// skip bytes until a valid address + length pair is found, wait for the whole frame,
+// then check the CRC in place. Only the start index moves, nothing is shifted,
+// so resync and frame consumption cost O(1) per byte and the CRC only runs on plausible frames.
 void CRSF::handleByteReceived()
 {
-    bool reprocess;
-    int maxPackets = 5;
-    do
+    while (rxRingCount() >= 2)
     {
-        reprocess = false;
-        if (_rxBufPos > 1)
+        uint8_t addr = _rxRing[_rxHead];
+        uint8_t len = _rxRing[(_rxHead + 1) & CRSF_RX_RING_MASK];
+        // Sanity check the declared length, can't be shorter than Type, X, CRC
+        if (!crsfIsFrameStart(addr) || len < 3 || len > CRSF_MAX_PACKET_LEN)
         {
-            uint8_t len = _rxBuf[1];
-            // Sanity check the declared length, can't be shorter than Type, X, CRC
-            if (len < 3 || len > CRSF_MAX_PACKET_LEN)
-            {
-                shiftRxBuffer(1);
-                reprocess = true;
-            }
+            _rxHead = (_rxHead + 1) & CRSF_RX_RING_MASK;
+#ifdef CRSF_PROFILE
+            _profile.rxSkippedBytes++;
+#endif
+            continue;
+        }
 
-            else if (_rxBufPos >= (len + 2))
+        if (rxRingCount() < len + 2)
+            return; // wait for the rest of the frame
+
+        uint8_t crc = 0;
+        uint8_t pos = (_rxHead + 2) & CRSF_RX_RING_MASK;
+        for (uint8_t i = 0; i < len - 1; i++)
+        {
+            crc = crsf_crc8_byte(crc, _rxRing[pos]);
+            pos = (pos + 1) & CRSF_RX_RING_MASK;
+        }
+
+        if (crc == _rxRing[pos])
+        {
+#ifdef CRSF_PROFILE
+            _profile.rxFrames++;
+#endif
+            // Payload may wrap around the ring, give the decoders a contiguous copy
+            pos = _rxHead;
+            for (uint8_t i = 0; i < len + 2; i++)
             {
-                uint8_t inCrc = _rxBuf[2 + len - 1];
-                //uint8_t crc = _crc.calc(&_rxBuf[2], len - 1);
-                uint8_t crc = crsf_crc8(&_rxBuf[2], len - 1);
-                
-                if (crc == inCrc)
-                {
-                    processPacketIn(len);
-                    shiftRxBuffer(len + 2);
-                    reprocess = true;
-                }
-                else
-                {
-                    shiftRxBuffer(1);
-                    reprocess = true;
-                }
-            }  // if complete packet
-        } // if pos > 1
-        
-        if(maxPackets <= 0) {
-          reprocess = false;
+                _rxBuf[i] = _rxRing[pos];
+                pos = (pos + 1) & CRSF_RX_RING_MASK;
+            }
+            _rxHead = pos;
+            _lastFrameMicros = micros();
+            processPacketIn(len);
+        }
+        else
+        {
+#ifdef CRSF_PROFILE
+            _profile.rxCrcErrors++;
+#endif
+            _rxHead = (_rxHead + 1) & CRSF_RX_RING_MASK;
         }
-        --maxPackets;
-        
-    } while (reprocess);
+    }
 }
 
 void CRSF::checkPacketTimeout()
 {
-    // If we haven't received data in a long time, flush the buffer a byte at a time (to trigger shiftyByte)
-    if (_rxBufPos > 0 && millis() - _lastReceive > CRSF_PACKET_TIMEOUT_MS)
-        while (_rxBufPos)
-            shiftRxBuffer(1);
+    // If we haven't received data in a long time, drop the partial frame
+    if (rxRingCount() > 0 && millis() - _lastReceive > CRSF_PACKET_TIMEOUT_MS)
+    {
+        _rxStats.droppedBytes += rxRingCount();
+        _rxHead = _rxTail;
+    }
 }
 
 void CRSF::checkLinkDown()
@@ -226,110 +356,205 @@ void CRSF::checkLinkDown()
     if (_linkIsUp && millis() - _lastChannelsPacket > CRSF_FAILSAFE_STAGE1_MS)
     {
         _linkIsUp = false;
+        _rideKeyValid = false;
+    }
+    // The remote gets no channels, there the link is lost when the TX module's link statistics and the ride frames stop.
+    // A receiver that comes back (or rebooted) restarts its keyframe sequence, deltas must not apply to the old keyframe.
+    if (_rideKeyValid && millis() - _lastLinkMillis > CRSF_LINK_LOST_MS)
+    {
+        _rideKeyValid = false;
     }
 }
 
+// Adding a telemetry frame only takes a decoder and a line here
+const CRSF::FrameHandlerEntry CRSF::frameHandlers[] = {
+    { CRSF_FRAMETYPE_BATTERY_SENSOR, sizeof(crsf_sensor_battery_t), &CRSF::packetBattery },
+    { CRSF_FRAMETYPE_LINK_STATISTICS, sizeof(crsfLinkStatistics_t), &CRSF::packetLinkStatistics },
+    { CRSF_FRAMETYPE_GPS, sizeof(crsf_sensor_gps_t), &CRSF::packetGps },
+    { CRSF_FRAMETYPE_BARO_ALTITUDE, sizeof(crsf_sensor_baro_altitude_t), &CRSF::packetBaroAltitude },
+    { CRSF_FRAMETYPE_VARIO, sizeof(crsf_sensor_vario_t), &CRSF::packetVario },
+    { CRSF_FRAMETYPE_ATTITUDE, sizeof(crsf_sensor_attitude_t), &CRSF::packetAttitude },
+    { CRSF_FRAMETYPE_RC_CHANNELS_PACKED, 0, &CRSF::packetChannelsPacked },
+    { CRSF_FRAMETYPE_RADIO_ID, sizeof(crsf_radio_id_sync_t), &CRSF::packetRadioId },
+    { CRSF_FRAMETYPE_ARDUPILOT_RESP, 1, &CRSF::packetArdupilot },
+};
+const uint8_t CRSF::frameHandlerCount = sizeof(frameHandlers) / sizeof(frameHandlers[0]);
+
 void CRSF::processPacketIn(uint8_t len)
 {
     const crsf_header_t *hdr = (crsf_header_t *)_rxBuf;
-    if (hdr->device_addr == CRSF_ADDRESS_RADIO_TRANSMITTER) //WORKS FOR TELEMETRY TO TX MODULE
+    if (hdr->device_addr != CRSF_ADDRESS_RADIO_TRANSMITTER) //WORKS FOR TELEMETRY TO TX MODULE
+        return;
+
+    crsfFrameView_t frame;
+    frame.type = hdr->type;
+    if (hdr->type >= CRSF_FRAMETYPE_EXTENDED_START)
     {
-        switch (hdr->type)
+        if (len < CRSF_FRAME_LENGTH_EXT_TYPE_CRC)
+            return;
+        frame.dest = hdr->data[0];
+        frame.origin = hdr->data[1];
+        frame.payload = &hdr->data[2];
+        frame.len = len - CRSF_FRAME_LENGTH_EXT_TYPE_CRC;
+    }
+    else
+    {
+        frame.dest = 0;
+        frame.origin = 0;
+        frame.payload = hdr->data;
+        frame.len = len - CRSF_FRAME_LENGTH_TYPE_CRC;
+    }
+
+    for (uint8_t i = 0; i < frameHandlerCount; i++)
+    {
+        if (frameHandlers[i].type == frame.type)
         {
-        case CRSF_FRAMETYPE_BATTERY_SENSOR:
-            packetBattery(hdr);
-            break;
-        case CRSF_FRAMETYPE_GPS:
-            packetGps(hdr);
-            break;
-        case CRSF_FRAMETYPE_RC_CHANNELS_PACKED:
-            packetChannelsPacked(hdr);
-            break;
-        case CRSF_FRAMETYPE_LINK_STATISTICS:
-            packetLinkStatistics(hdr);
-            break;
-        case CRSF_FRAMETYPE_BARO_ALTITUDE:
-            packetBaroAltitude(hdr);
-            break;
-        case CRSF_FRAMETYPE_VARIO:
-            packetVario(hdr);
-            break;
+            if (frame.len >= frameHandlers[i].minLen)
+                (this->*frameHandlers[i].handler)(frame);
+            return;
         }
-    } 
-    //else if (hdr->device_addr == CRSF_ADDRESS_CRSF_TRANSMITTER) //Headset to TX
-    //{
-        //if (hdr->type == CRSF_FRAMETYPE_RC_CHANNELS_PACKED)
-        //{
-        //    packetChannelsPacked(hdr);
-        //}
-    //}
+    }
 }
 
-// Shift the bytes in the RxBuf down by cnt bytes
-void CRSF::shiftRxBuffer(uint8_t cnt)
+void CRSF::packetLinkStatistics(const crsfFrameView_t &frame)
 {
-    // If removing the whole thing, just set pos to 0
-    if (cnt >= _rxBufPos)
-    {
-        _rxBufPos = 0;
-        return;
-    }
+    crsfLinkStatistics_t &link = _telemetry.beginWrite().link;
+    link.uplink_RSSI_1 = frame.u8(0);
+    link.uplink_RSSI_2 = frame.u8(1);
+    link.uplink_Link_quality = frame.u8(2);
+    link.uplink_SNR = (int8_t)frame.u8(3);
+    link.active_antenna = frame.u8(4);
+    link.rf_Mode = frame.u8(5);
+    link.uplink_TX_Power = frame.u8(6);
+    link.downlink_RSSI = frame.u8(7);
+    link.downlink_Link_quality = frame.u8(8);
+    link.downlink_SNR = (int8_t)frame.u8(9);
+    _telemetry.endWrite(CRSF_TELEMETRY_LINK);
+
+    if (frame.u8(2) > 0) // uplink LQ
+        _lastLinkMillis = millis();
+    else
+        _rideKeyValid = false; // receiver lost
+}
+
+void CRSF::packetGps(const crsfFrameView_t &frame)
+{
+    crsf_sensor_gps_t &gps = _telemetry.beginWrite().gps;
+    gps.latitude = (int32_t)frame.u32(0);
+    gps.longitude = (int32_t)frame.u32(4);
+    gps.groundspeed = frame.u16(8);
+    gps.heading = frame.u16(10);
+    gps.altitude = frame.u16(12);
+    gps.satellites = frame.u8(14);
+    _telemetry.endWrite(CRSF_TELEMETRY_GPS);
+}
 
-    // Otherwise do the slow shift down
-    uint8_t *src = &_rxBuf[cnt];
-    uint8_t *dst = &_rxBuf[0];
-    _rxBufPos -= cnt;
-    uint8_t left = _rxBufPos;
-    while (left--)
-        *dst++ = *src++;
+void CRSF::packetVario(const crsfFrameView_t &frame)
+{
+    _telemetry.beginWrite().vario.verticalspd = (int16_t)frame.u16(0);
+    _telemetry.endWrite(CRSF_TELEMETRY_VARIO);
 }
-void CRSF::packetLinkStatistics(const crsf_header_t *p)
+
+void CRSF::packetBaroAltitude(const crsfFrameView_t &frame)
 {
-    const crsfLinkStatistics_t *link = (crsfLinkStatistics_t *)p->data;
-    memcpy(&_linkStatistics, link, sizeof(_linkStatistics));
+    crsf_sensor_baro_altitude_t &baro = _telemetry.beginWrite().baro;
+    baro.altitude = frame.u16(0);
+    baro.verticalspd = (int16_t)frame.u16(2);
+    _telemetry.endWrite(CRSF_TELEMETRY_BARO);
 }
 
-void CRSF::packetGps(const crsf_header_t *p)
+void CRSF::packetAttitude(const crsfFrameView_t &frame)
 {
-    const crsf_sensor_gps_t *gps = (crsf_sensor_gps_t *)p->data;
-    _gpsSensor.latitude = be32toh(gps->latitude);
-    _gpsSensor.longitude = be32toh(gps->longitude);
-    _gpsSensor.groundspeed = be16toh(gps->groundspeed);
-    _gpsSensor.heading = be16toh(gps->heading);
-    _gpsSensor.altitude = be16toh(gps->altitude);
-    _gpsSensor.satellites = gps->satellites;
+    crsf_sensor_attitude_t &attitude = _telemetry.beginWrite().attitude;
+    attitude.pitch = frame.u16(0);
+    attitude.roll = frame.u16(2);
+    attitude.yaw = frame.u16(4);
+    _telemetry.endWrite(CRSF_TELEMETRY_ATTITUDE);
 }
 
-void CRSF::packetVario(const crsf_header_t *p)
+void CRSF::packetBattery(const crsfFrameView_t &frame)
 {
-    const crsf_sensor_vario_t *vario = (crsf_sensor_vario_t *)p->data;
-    _varioSensor.verticalspd = be16toh(vario->verticalspd);
+    crsf_sensor_battery_t &battery = _telemetry.beginWrite().battery;
+    battery.voltage = frame.u16(0);
+    battery.current = frame.u16(2);
+    battery.capacity = frame.u24(4);
+    battery.remaining = frame.u8(7);
+    _telemetry.endWrite(CRSF_TELEMETRY_BATTERY);
 }
 
-void CRSF::packetBaroAltitude(const crsf_header_t *p)
+void CRSF::packetRadioId(const crsfFrameView_t &frame)
 {
-    const crsf_sensor_baro_altitude_t *baroAltitude = (crsf_sensor_baro_altitude_t *)p->data;
-    _baroAltitudeSensor.altitude = be16toh(baroAltitude->altitude);
-    _baroAltitudeSensor.verticalspd = be16toh(baroAltitude->verticalspd);
+    if (frame.u8(0) != CRSF_RADIO_ID_TIMING_SYNC)
+        return;
+    _syncIntervalUs = (int32_t)frame.u32(1) / 10;
+    _syncOffsetUs = (int32_t)frame.u32(5) / 10;
+    _syncUpdated = true;
 }
 
-void CRSF::packetAttitude(const crsf_header_t *p)
+// Bits of each ride field, negative for signed, in the order they are packed
+static const int8_t rideFieldBits[CRSF_ELRSK8_RIDE_FIELDS] = {-12, -12, 13, 9, 9, 16, 20};
+
+static void unpackRide(const crsfFrameView_t &frame, uint16_t bit, int32_t raw[CRSF_ELRSK8_RIDE_FIELDS])
 {
-    const crsf_sensor_attitude_t *attitude = (crsf_sensor_attitude_t *)p->data;
-    _attitudeSensor.pitch = be16toh(attitude->pitch);
-    _attitudeSensor.roll = be16toh(attitude->roll);
-    _attitudeSensor.yaw = be16toh(attitude->yaw);
+    for (uint8_t i = 0; i < CRSF_ELRSK8_RIDE_FIELDS; i++)
+        raw[i] = rideFieldBits[i] < 0 ? frame.sbits(bit, -rideFieldBits[i]) : (int32_t)frame.bits(bit, rideFieldBits[i]);
+}
+
+void CRSF::packetArdupilot(const crsfFrameView_t &frame)
+{
+    // Only the ELRSk8 ride frames, not ArduPilot's own passthrough subtypes
+    int32_t raw[CRSF_ELRSK8_RIDE_FIELDS];
+    switch (frame.u8(0))
+    {
+    case CRSF_ELRSK8_RIDE:
+        if (frame.len < CRSF_ELRSK8_RIDE_LEN)
+            return;
+        unpackRide(frame, 8, raw);
+        break;
+    case CRSF_ELRSK8_RIDE_KEY:
+        if (frame.len < CRSF_ELRSK8_RIDE_LEN + 1)
+            return;
+        unpackRide(frame, 16, _rideKey);
+        _rideKeySeq = frame.u8(1);
+        _rideKeyValid = true;
+        memcpy(raw, _rideKey, sizeof(raw));
+        break;
+    case CRSF_ELRSK8_RIDE_DELTA:
+    {
+        // Changes since a keyframe we never got are meaningless, wait for the next one
+        bool valid = _rideKeyValid && frame.len >= 2 && frame.u8(1) == _rideKeySeq;
+        uint8_t offset = 2;
+        for (uint8_t i = 0; valid && i < CRSF_ELRSK8_RIDE_FIELDS; i++)
+        {
+            int32_t delta;
+            valid = frame.varint(offset, delta);
+            raw[i] = _rideKey[i] + delta;
+        }
+        if (!valid)
+        {
+            _rxStats.rideDeltasDropped++;
+            return;
+        }
+        break;
+    }
+    default:
+        return;
+    }
+    _lastLinkMillis = millis();
+    storeRide(raw);
 }
 
-void CRSF::packetBattery(const crsf_header_t *p)
+void CRSF::storeRide(const int32_t raw[CRSF_ELRSK8_RIDE_FIELDS])
 {
-    //crsf_sensor_battery_t battery
-    const crsf_sensor_battery_t *battery = (crsf_sensor_battery_t *)p->data;
-    _battery.voltage = be16toh(battery->voltage);
-    _battery.current = be16toh(battery->current);
-    //_battery.capacity = be32toh(battery->capacity >> 8);
-    _battery.capacity = be16toh(battery->capacity >> 8);
-    _battery.remaining = battery->remaining;
+    crsf_elrsk8_ride_t &ride = _telemetry.beginWrite().ride;
+    ride.speed = raw[0];
+    ride.current = raw[1];
+    ride.cellVoltage = raw[2];
+    ride.tempEsc = raw[3] * 5 - 200;
+    ride.tempMotor = raw[4] * 5 - 200;
+    ride.wattHours = raw[5];
+    ride.distance = raw[6];
+    _telemetry.endWrite(CRSF_TELEMETRY_RIDE);
 }
 
 void CRSF::write(uint8_t b)
@@ -369,10 +594,10 @@ void CRSF::write(const uint8_t *buf, size_t len)
 //    write(buf, len + 4);
 //}
 
-void CRSF::packetChannelsPacked(const crsf_header_t *p)
+void CRSF::packetChannelsPacked(const crsfFrameView_t &frame)
 {
     /*
-    crsf_channels_t *ch = (crsf_channels_t *)&p->data;
+    crsf_channels_t *ch = (crsf_channels_t *)frame.payload;
     _channels[0] = ch->ch0;
     _channels[1] = ch->ch1;
     _channels[2] = ch->ch2;
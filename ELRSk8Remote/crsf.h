@@ -4,6 +4,8 @@
 
 #include <Arduino.h>
 #include <stdint.h>
+#include "channelPacker.h"
+#include "crc8.h"
 
 /*
  * This file is part of Simple TX
@@ -25,6 +27,10 @@
 // Basic setup
 #define CRSF_MAX_CHANNEL        16
 #define CRSF_FRAME_SIZE_MAX     64
+// Uncomment to collect CRSF timing statistics (printed to USB Serial once per second)
+//#define CRSF_PROFILE
+// Uncomment to timestamp every stage from throttle sample to the last byte in the UART (printed to USB Serial once per second)
+//#define LATENCY_PROFILE
 // Device address & type
 #define RADIO_ADDRESS           0xEA
 // #define ADDR_MODULE             0xEE  //  Crossfire transmitter
@@ -43,8 +49,9 @@ const float CRSFMax = CRSF_DIGITAL_CHANNEL_MAX;
 //#define CRSF_SERIAL_BAUDRATE                 115200 //low baud for Arduino Nano , the TX module will auto detect baud. 115200/40000
 //#define CRSF_SERIAL_BAUDRATE                 420000
 //#define CRSF_SERIAL_BAUDRATE                 400000
-#define CRSF_TIME_BETWEEN_FRAMES_US     4000 // 4 ms 250Hz
-//#define CRSF_TIME_BETWEEN_FRAMES_US     1666 // 1.6 ms 500Hz
+#define CRSF_TIME_BETWEEN_FRAMES_US     4000 // 4 ms 250Hz, default until setFrameInterval() is called
+#define CRSF_RX_BUDGET_DIVIDER          8    // handleSerialIn() drains the UART for at most 1/8 of a frame interval
+#define CRSF_RX_BUDGET_US               (CRSF_TIME_BETWEEN_FRAMES_US / CRSF_RX_BUDGET_DIVIDER)
 #define CRSF_PAYLOAD_OFFSET             offsetof(crsfFrameDef_t, type)
 #define CRSF_MSP_RX_BUF_SIZE            128
 #define CRSF_MSP_TX_BUF_SIZE            128
@@ -55,9 +62,12 @@ const float CRSFMax = CRSF_DIGITAL_CHANNEL_MAX;
 #define CRSF_CMD_PACKET_SIZE            8
 #define CRSF_MAX_PACKET_LEN 64
 #define CRSF_SYNC_BYTE 0XC8
+#define CRSF_RX_RING_SIZE 128 // power of two, fits a max size frame plus the start of the next one
+#define CRSF_RX_RING_MASK (CRSF_RX_RING_SIZE - 1)
 
 static const unsigned int CRSF_PACKET_TIMEOUT_MS = 100;
 static const unsigned int CRSF_FAILSAFE_STAGE1_MS = 300;
+static const unsigned int CRSF_LINK_LOST_MS = 5000; // no link statistics or ride frames for this long, 1:128 at 50Hz still sends every ~2.5s
     
 // ELRS command
 #define ELRS_ADDRESS                    0xEE
@@ -90,8 +100,19 @@ enum chan_order
 };
 
 
+// Channel frame interval for every ELRS 3.x 2.4GHz [Packet Rate] option, the handset has to match the air rate
+// 0 - 50Hz / 1 - 100Hz Full / 2 - 150Hz / 3 - 250Hz / 4 - 333Hz Full / 5 - 500Hz / 6 - D250 / 7 - D500 / 8 - F500 / 9 - F1000
+static const uint16_t elrsPacketRateIntervalUs[] = {20000, 10000, 6666, 4000, 3003, 2000, 4000, 2000, 2000, 1000};
+
+static inline uint32_t crsfFrameIntervalUs(int packetRate)
+{
+    if (packetRate < 0 || packetRate >= (int)(sizeof(elrsPacketRateIntervalUs) / sizeof(elrsPacketRateIntervalUs[0])))
+        return CRSF_TIME_BETWEEN_FRAMES_US;
+    return elrsPacketRateIntervalUs[packetRate];
+}
+
 // ELRS 3.x (ESP8266 based TX module): with thanks to r-u-t-r-A (https://github.com/r-u-t-r-A/STM32-ELRS-Handset/tree/v4.5)
-//  1 : Set Lua [Packet Rate]= 0 - 50Hz / 1 - 100Hz Full / 2- 150Hz / 3 - 250Hz / 4 - 333Hz Full / 5 - 500Hz
+//  1 : Set Lua [Packet Rate]= 0 - 50Hz / 1 - 100Hz Full / 2- 150Hz / 3 - 250Hz / 4 - 333Hz Full / 5 - 500Hz / 6 - D250 / 7 - D500 / 8 - F500 / 9 - F1000
 //  2 : Set Lua [Telem Ratio]= 0 - Std / 1 - Off / 2 - 1:128 / 3 - 1:64 / 4 - 1:32 / 5 - 1:16 / 6 - 1:8 / 7 - 1:4 / 8 - 1:2 / 9 - Race
 //  3 : Set Lua [Switch Mode]=0 -> Hybrid;Wide
 //  4 : Set Lua [Model Match]=0 -> Off;On
@@ -134,7 +155,7 @@ typedef enum
     //CRSF_FRAMETYPE_VIDEO_TRANSMITTER = 0x0F,           //no need to support? (rev07)
     CRSF_FRAMETYPE_LINK_STATISTICS = 0x14,
     // CRSF_FRAMETYPE_OPENTX_SYNC = 0x10,               //not in edgeTX
-    // CRSF_FRAMETYPE_RADIO_ID = 0x3A,                  //no need to support?
+    CRSF_FRAMETYPE_RADIO_ID = 0x3A,                     // extended header, carries the module timing sync
     CRSF_FRAMETYPE_RC_CHANNELS_PACKED = 0x16,
     // CRSF_FRAMETYPE_LINK_RX_ID = 0x1C,                 //no need to support?
     // CRSF_FRAMETYPE_LINK_TX_ID = 0x1D,                 //no need to support?
@@ -155,9 +176,11 @@ typedef enum
     // CRSF_FRAMETYPE_MSP_RESP = 0x7B,                  //not in edgeTX
     // CRSF_FRAMETYPE_MSP_WRITE = 0x7C,                 //not in edgeTX
   // Ardupilot frames
-    // CRSF_FRAMETYPE_ARDUPILOT_RESP = 0x80,
+    CRSF_FRAMETYPE_ARDUPILOT_RESP = 0x80,               // extended header, ELRS forwards it, the ELRSk8 receiver sends its ride frame in it
 } crsf_frame_type_e;
 
+#define CRSF_RADIO_ID_TIMING_SYNC 0x10 // RADIO_ID subtype: packet interval + phase offset, both in 0.1 us
+
 typedef enum
 {
     CRSF_ADDRESS_BROADCAST = 0x00,
@@ -236,6 +259,194 @@ typedef struct crsf_sensor_attitude_s
     uint16_t yaw;  // yaw in radians, BigEndian
 } PACKED crsf_sensor_attitude_t;
 
+// Telemetry groups that get their own arrival timestamp
+enum crsfTelemetryField_e
+{
+    CRSF_TELEMETRY_BATTERY,
+    CRSF_TELEMETRY_LINK,
+    CRSF_TELEMETRY_GPS,
+    CRSF_TELEMETRY_VARIO,
+    CRSF_TELEMETRY_BARO,
+    CRSF_TELEMETRY_ATTITUDE,
+    CRSF_TELEMETRY_RIDE,
+    CRSF_TELEMETRY_FIELD_COUNT,
+};
+
+// ELRSk8 ride frame: ARDUPILOT_RESP with its own subtype, then every ride value bit packed MSB first
+// in the order and widths below (91 bits in 12 bytes), sent by the receiver's sendRidePacked()
+#define CRSF_ELRSK8_RIDE 0x4B
+#define CRSF_ELRSK8_RIDE_KEY 0x4C   // keyframe sequence, then the packed fields
+#define CRSF_ELRSK8_RIDE_DELTA 0x4D // keyframe sequence, then each packed field's change since that keyframe, zigzag varints
+#define CRSF_ELRSK8_RIDE_LEN 13     // subtype + packed fields
+#define CRSF_ELRSK8_RIDE_FIELDS 7
+
+typedef struct crsf_elrsk8_ride_s
+{
+    int16_t speed;        // 0.1 km/h (mph), 12 bit signed
+    int16_t current;      // 0.1 A, 12 bit signed
+    uint16_t cellVoltage; // mV, 13 bit
+    int16_t tempEsc;      // 0.1 C, sent as 0.5 C steps from -20 C in 9 bit
+    int16_t tempMotor;    // 0.1 C, same as tempEsc
+    uint16_t wattHours;   // 0.1 Wh used, 16 bit
+    uint32_t distance;    // 0.01 km (mi), 20 bit
+} crsf_elrsk8_ride_t;
+
+// Decoded telemetry, host byte order
+typedef struct crsfTelemetry_s
+{
+    crsf_sensor_battery_t battery;
+    crsfLinkStatistics_t link;
+    crsf_sensor_gps_t gps;
+    crsf_sensor_vario_t vario;
+    crsf_sensor_baro_altitude_t baro;
+    crsf_sensor_attitude_t attitude;
+    crsf_elrsk8_ride_t ride;
+    uint32_t updatedMillis[CRSF_TELEMETRY_FIELD_COUNT]; // millis() when the field last arrived
+    uint8_t receivedMask;                                // bit per field, set once it arrived at least once
+
+    bool isFresh(crsfTelemetryField_e field, uint32_t maxAgeMs, uint32_t now) const
+    {
+        return (receivedMask & (1 << field)) && now - updatedMillis[field] <= maxAgeMs;
+    }
+} crsfTelemetry_t;
+
+// Seqlock around the decoded telemetry: the parser (even from an interrupt) bumps the sequence to odd,
+// writes, and bumps it back to even. Readers copy and retry if the sequence was odd or moved,
+// so they always get a consistent set without disabling interrupts.
+class TelemetryStore
+{
+public:
+    crsfTelemetry_t &beginWrite()
+    {
+        _seq++;
+        __sync_synchronize();
+        return _data;
+    }
+
+    void endWrite(crsfTelemetryField_e field)
+    {
+        _data.updatedMillis[field] = millis();
+        _data.receivedMask |= 1 << field;
+        __sync_synchronize();
+        _seq++;
+    }
+
+    void snapshot(crsfTelemetry_t &out) const
+    {
+        uint32_t seq;
+        do
+        {
+            seq = _seq;
+            __sync_synchronize();
+            memcpy(&out, (const void *)&_data, sizeof(out));
+            __sync_synchronize();
+        } while ((seq & 1) || seq != _seq);
+    }
+
+    uint32_t sequence() const { return _seq; }
+
+private:
+    volatile uint32_t _seq = 0;
+    crsfTelemetry_t _data = {};
+};
+
+typedef struct crsf_radio_id_sync_s
+{
+    uint8_t subtype;  // CRSF_RADIO_ID_TIMING_SYNC
+    int32_t rate;     // module packet interval in 0.1 us, BigEndian
+    int32_t offset;   // how early the last channel frame arrived in 0.1 us, BigEndian
+} PACKED crsf_radio_id_sync_t; // payload after the extended header
+
+#define CRSF_FRAMETYPE_EXTENDED_START 0x28 // frame types from here on carry dest + origin before the payload
+
+// Read-only view of a validated frame, decoders pull big endian fields straight out of the receive buffer
+struct crsfFrameView_t
+{
+    const uint8_t *payload; // first byte after the (extended) header
+    uint8_t len;            // payload length, without CRC
+    uint8_t type;
+    uint8_t dest;           // extended header frames only
+    uint8_t origin;
+
+    uint8_t u8(uint8_t offset) const { return payload[offset]; }
+    uint16_t u16(uint8_t offset) const { return ((uint16_t)payload[offset] << 8) | payload[offset + 1]; }
+    uint32_t u24(uint8_t offset) const { return ((uint32_t)payload[offset] << 16) | ((uint32_t)payload[offset + 1] << 8) | payload[offset + 2]; }
+    uint32_t u32(uint8_t offset) const { return ((uint32_t)u16(offset) << 16) | u16(offset + 2); }
+
+    // Bit packed fields, MSB first, bitOffset moves past the field
+    uint32_t bits(uint16_t &bitOffset, uint8_t width) const
+    {
+        uint32_t v = 0;
+        for (uint8_t i = 0; i < width; i++, bitOffset++)
+            v = (v << 1) | ((payload[bitOffset >> 3] >> (7 - (bitOffset & 7))) & 1);
+        return v;
+    }
+    int32_t sbits(uint16_t &bitOffset, uint8_t width) const
+    {
+        return (int32_t)(bits(bitOffset, width) << (32 - width)) >> (32 - width);
+    }
+
+    // Zigzag varint, 7 bits per byte, low bits first. False if it runs past the payload
+    bool varint(uint8_t &offset, int32_t &value) const
+    {
+        uint32_t v = 0;
+        for (uint8_t shift = 0; shift < 35 && offset < len; shift += 7)
+        {
+            uint8_t b = payload[offset++];
+            v |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80))
+            {
+                value = (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+typedef struct crsfRxStats_s
+{
+    uint32_t droppedBytes;  // bytes lost to ring overflow or partial frame timeout
+    uint32_t deferredBytes; // bytes left in the UART when the drain budget ran out
+    uint32_t budgetHits;    // handleSerialIn() calls that ran out of budget
+    uint32_t rideDeltasDropped; // ride delta frames whose keyframe never arrived
+} crsfRxStats_t;
+
+typedef struct crsfTxStats_s
+{
+    uint32_t frames;         // frames fully handed to the UART
+    uint32_t overruns;       // queued frames replaced before they were sent
+    uint32_t blockingWrites; // whole frames written at once: core without availableForWrite(), or a UART stalled for a frame interval
+} crsfTxStats_t;
+
+#ifdef CRSF_PROFILE
+typedef struct crsfProfile_s
+{
+    uint32_t rxCalls;           // handleSerialIn() calls
+    uint32_t rxBytes;           // bytes read from the module
+    uint32_t rxFrames;          // frames with a valid CRC
+    uint32_t rxCrcErrors;       // complete frames dropped on CRC mismatch
+    uint32_t rxSkippedBytes;    // bytes skipped while searching for a frame start
+    uint32_t rxMicros;          // total time spent in handleSerialIn()
+    uint32_t rxMaxCallMicros;   // worst single handleSerialIn() call
+    uint32_t txPackets;         // crsfPrepareDataPacket() calls
+    uint32_t txPrepareMicros;   // total time spent packing channels + CRC
+    uint32_t txMaxPrepareMicros;
+} crsfProfile_t;
+#endif
+
+#ifdef LATENCY_PROFILE
+// Stage timestamps (micros) of the last channel frame
+typedef struct crsfLatencyStamps_s
+{
+    uint32_t packed;     // channels repacked
+    uint32_t crcDone;    // CRC done, frame copied out
+    uint32_t writeStart; // first byte handed to the UART
+    uint32_t writeDone;  // last byte handed to the UART
+    uint32_t frames;     // channel frames completed, a change means the stamps are a new set
+} crsfLatencyStamps_t;
+#endif
+
 
 
 
@@ -247,6 +458,8 @@ public:
     void crsfPrepareDataPacket(uint8_t packet[], int16_t channels[]);
     void crsfPrepareCmdPacket(uint8_t packetCmd[], uint8_t command, uint8_t value);
     void CrsfWritePacket(uint8_t packet[], uint8_t packetLength);
+    void pumpTx();
+    bool txIdle() const { return _txPending == 0; }
 
     //TELEM
 
@@ -257,36 +470,84 @@ public:
    
     
     void handleSerialIn();
+    void setRxBudget(uint32_t budgetUs) { _rxBudgetUs = budgetUs; }
+    void setFrameInterval(uint32_t intervalUs);
     void handleByteReceived();
-    void shiftRxBuffer(uint8_t cnt);
+    uint8_t rxRingCount() const { return (_rxTail - _rxHead) & CRSF_RX_RING_MASK; }
     void processPacketIn(uint8_t len);
     void checkPacketTimeout();
     void checkLinkDown();
 
-    void packetLinkStatistics(const crsf_header_t *p);
-    void packetGps(const crsf_header_t *p);
-    void packetVario(const crsf_header_t *p);
-    void packetBaroAltitude(const crsf_header_t *p);
-    void packetAttitude(const crsf_header_t *p);
-    void packetBattery(const crsf_header_t *p);
-    void packetChannelsPacked(const crsf_header_t *p);
+    void packetLinkStatistics(const crsfFrameView_t &frame);
+    void packetGps(const crsfFrameView_t &frame);
+    void packetVario(const crsfFrameView_t &frame);
+    void packetBaroAltitude(const crsfFrameView_t &frame);
+    void packetAttitude(const crsfFrameView_t &frame);
+    void packetBattery(const crsfFrameView_t &frame);
+    void packetChannelsPacked(const crsfFrameView_t &frame);
+    void packetRadioId(const crsfFrameView_t &frame);
+    void packetArdupilot(const crsfFrameView_t &frame);
+    void storeRide(const int32_t raw[CRSF_ELRSK8_RIDE_FIELDS]);
+
+    // Frame decoders, one entry per frame type, see frameHandlers[] in crsf.cpp
+    typedef void (CRSF::*FrameHandler)(const crsfFrameView_t &frame);
+    struct FrameHandlerEntry
+    {
+        uint8_t type;
+        uint8_t minLen; // shorter payloads are ignored
+        FrameHandler handler;
+    };
+    static const FrameHandlerEntry frameHandlers[];
+    static const uint8_t frameHandlerCount;
     
     //TELEM
     CRSF();
-    uint8_t _rxBuf[CRSF_MAX_PACKET_LEN+3];
-    uint8_t _rxBufPos;
+    uint8_t _rxRing[CRSF_RX_RING_SIZE];
+    uint8_t _rxHead; // first unparsed byte
+    uint8_t _rxTail; // next free slot
+    uint8_t _rxBuf[CRSF_MAX_PACKET_LEN+3]; // contiguous copy of the last valid frame
     //Crc8 _crc;
-    crsfLinkStatistics_t _linkStatistics;
-    crsf_sensor_gps_t _gpsSensor;
-    crsf_sensor_vario_t _varioSensor;
-    crsf_sensor_baro_altitude_t _baroAltitudeSensor;
-    crsf_sensor_attitude_t _attitudeSensor;
-    crsf_sensor_battery_t _battery;
+    ChannelPacker<CRSF_MAX_CHANNEL, 11> _channelPacker;
+    uint8_t _dataPacket[CRSF_PACKET_SIZE];
+    uint8_t _crcState[CRSF_FRAME_LENGTH]; // CRC after each byte of type + payload, reused for unchanged bytes
+    TelemetryStore _telemetry; // read it with _telemetry.snapshot()
+    uint32_t _syncIntervalUs; // ELRS module timing sync, 0 until the first sync frame
+    int32_t _syncOffsetUs;
+    bool _syncUpdated;        // set on every sync frame, cleared by the consumer
+    int32_t _rideKey[CRSF_ELRSK8_RIDE_FIELDS]; // packed fields of the last ride keyframe, the deltas add to these
+    uint8_t _rideKeySeq;
+    bool _rideKeyValid;
     
+    // Double buffered transmit queue: one frame feeding the UART, one waiting behind it
+    uint8_t _txBuf[2][CRSF_FRAME_SIZE_MAX];
+    uint8_t _txLen[2];
+    uint8_t _txSlot;    // slot currently being sent
+    uint8_t _txPos;     // bytes of the current slot already handed to the UART
+    uint8_t _txPending; // queued frames, including the one being sent
+    bool _txRoomReported; // availableForWrite() returned nonzero at least once, so a 0 means full rather than unsupported
+    uint32_t _txStartMicros;
+    crsfTxStats_t _txStats;
+
+    uint32_t _frameIntervalUs;
+    uint32_t _rxBudgetUs;
+    uint32_t _lastFrameMicros; // arrival time of the last valid frame
+    crsfRxStats_t _rxStats;
     uint32_t _baud;
     uint32_t _lastReceive;
     uint32_t _lastChannelsPacket;
+    uint32_t _lastLinkMillis; // last sign of the air link: link statistics with uplink LQ > 0, or a ride frame
     bool _linkIsUp;
+
+#ifdef CRSF_PROFILE
+    crsfProfile_t _profile;
+    void resetProfile();
+#endif
+
+#ifdef LATENCY_PROFILE
+    crsfLatencyStamps_t _latency;
+    bool _latencyArmed;     // a channel frame was prepared, the next queued frame gets stamped
+    uint8_t _latencySlot;   // tx slot of the stamped frame, 0xFF = none
+#endif
 };
 
 
@@ -0,0 +1,75 @@
+#ifndef FIXEDFORMAT_H
+#define FIXEDFORMAT_H
+
+#include <stdint.h>
+
+//FIXED POINT NUMBER FORMATTING FOR THE SCREEN
+//Values stay integers scaled by 10^inputDecimals (mV, 0.1km, ...), no float code and no dtostrf.
+//The number is right aligned in width characters, so the unit after it never moves when the digit count changes.
+//Rounding is half away from zero, a number that doesn't fit is shown as width '#' instead of being cut.
+
+struct FixedFormat {
+  uint8_t width;         //characters for the number, sign and decimal point included
+  uint8_t decimals;      //decimals shown
+  uint8_t inputDecimals; //value is in units of 10^-inputDecimals
+  const char *unit;      //written right after the number
+};
+
+const uint32_t fixedPow10[] = {1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL};
+const uint8_t fixedMaxDigits = 10;
+
+//Writes the number and unit to dst without a terminator, returns the characters written
+inline uint8_t formatFixed(char *dst, int32_t value, const FixedFormat &spec) {
+  bool negative = value < 0;
+  uint32_t magnitude = negative ? 0UL - (uint32_t)value : (uint32_t)value;
+  bool overflow = false;
+
+  if(spec.decimals < spec.inputDecimals) {
+    uint32_t divider = fixedPow10[spec.inputDecimals - spec.decimals];
+    magnitude = magnitude / divider + (magnitude % divider >= (divider + 1) / 2 ? 1 : 0);
+  }
+  else if(spec.decimals > spec.inputDecimals) {
+    uint32_t multiplier = fixedPow10[spec.decimals - spec.inputDecimals];
+    overflow = magnitude > 0xFFFFFFFFUL / multiplier;
+    magnitude *= multiplier;
+  }
+  if(magnitude == 0) {
+    negative = false; //-0.004 shown with 2 decimals is 0.00, not -0.00
+  }
+
+  //DIGITS RIGHT TO LEFT, at least one before the decimal point
+  char digits[fixedMaxDigits + 2];
+  uint8_t count = 0;
+  do {
+    if(count == spec.decimals && spec.decimals > 0) {
+      digits[count++] = '.';
+    }
+    digits[count++] = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while(magnitude > 0 || count <= spec.decimals);
+  if(negative) {
+    digits[count++] = '-';
+  }
+
+  uint8_t pos = 0;
+  if(overflow || count > spec.width) {
+    while(pos < spec.width) {
+      dst[pos++] = '#';
+    }
+  }
+  else {
+    while(pos < spec.width - count) {
+      dst[pos++] = ' ';
+    }
+    while(count > 0) {
+      dst[pos++] = digits[--count];
+    }
+  }
+
+  for(const char *u = spec.unit;u && *u;++u) {
+    dst[pos++] = *u;
+  }
+  return pos;
+}
+
+#endif
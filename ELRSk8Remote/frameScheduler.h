@@ -0,0 +1,113 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <Arduino.h>
+
+//CHANNEL FRAME SCHEDULER
+//Frames are due on absolute deadlines (start + n * interval), a late loop() only delays that one frame,
+//the next deadline stays where it was, so lateness never adds up into drift and the average rate is exact.
+
+//Upper bounds (us) of the lateness histogram buckets, the last bucket takes everything above
+const uint16_t jitterBucketLimits[] = {10, 25, 50, 100, 250, 500, 1000, 2000};
+const int jitterBucketCount = sizeof(jitterBucketLimits) / sizeof(jitterBucketLimits[0]) + 1;
+
+//ELRS TX module wants the handset packet this long before it goes over the air (same as EdgeTX SAFE_SYNC_LAG)
+const int32_t moduleSyncTargetLagUs = 800;
+
+class FrameScheduler
+{
+public:
+    uint32_t jitterHistogram[jitterBucketCount];
+    uint32_t maxLateness = 0;
+    uint32_t missedFrames = 0;
+
+    void Setup(uint32_t intervalUs) {
+      interval = intervalUs;
+      nextDeadline = micros() + interval;
+      ResetStats();
+    }
+
+    //True once per interval, call as often as possible from loop()
+    bool Due(uint32_t now) {
+      int32_t late = (int32_t)(now - nextDeadline);
+      if (late < 0) {
+        return false;
+      }
+
+      RecordLateness(late);
+      if ((uint32_t)late >= interval) {
+        //MISSED WHOLE FRAMES (blocking call somewhere), re-phase instead of sending a burst
+        missedFrames += late / interval;
+        nextDeadline = now + interval;
+      }
+      else {
+        nextDeadline += interval;
+      }
+      return true;
+    }
+
+    uint32_t Interval() const {
+      return interval;
+    }
+
+    void SetInterval(uint32_t intervalUs) {
+      nextDeadline += (int32_t)(intervalUs - interval);
+      interval = intervalUs;
+    }
+
+    uint32_t TimeToNextFrame(uint32_t now) const {
+      int32_t left = (int32_t)(nextDeadline - now);
+      return left > 0 ? left : 0;
+    }
+
+    //Phase lock to the ELRS module timing sync: take over its packet interval
+    //and nudge our deadline towards the lag it asks for, a quarter of the error per sync frame
+    void Sync(uint32_t moduleIntervalUs, int32_t moduleLagUs) {
+      if (moduleIntervalUs == 0) {
+        return;
+      }
+      SetInterval(moduleIntervalUs);
+      int32_t correction = (moduleLagUs - moduleSyncTargetLagUs) / 4;
+      int32_t limit = interval / 8;
+      correction = constrain(correction, -limit, limit);
+      nextDeadline += correction;
+    }
+
+    //Lateness percentile (0-100) in us, reported as the upper bound of the bucket it falls in
+    uint32_t LatenessPercentile(uint8_t percent) const {
+      uint32_t total = 0;
+      for (int i = 0; i < jitterBucketCount; ++i) {
+        total += jitterHistogram[i];
+      }
+      uint32_t target = (total * percent + 99) / 100;
+      uint32_t count = 0;
+      for (int i = 0; i < jitterBucketCount - 1; ++i) {
+        count += jitterHistogram[i];
+        if (count >= target) {
+          return jitterBucketLimits[i];
+        }
+      }
+      return maxLateness;
+    }
+
+    void ResetStats() {
+      memset(jitterHistogram, 0, sizeof(jitterHistogram));
+      maxLateness = 0;
+      missedFrames = 0;
+    }
+
+private:
+    uint32_t interval = 4000;
+    uint32_t nextDeadline = 0;
+
+    void RecordLateness(uint32_t late) {
+      int bucket = 0;
+      while (bucket < jitterBucketCount - 1 && late > jitterBucketLimits[bucket]) {
+        ++bucket;
+      }
+      ++jitterHistogram[bucket];
+      maxLateness = max(maxLateness, late);
+    }
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef LATENCYPROFILE_H
+#define LATENCYPROFILE_H
+
+#include <Arduino.h>
+
+//ROLLING LATENCY STATS
+//Keeps the last latencyWindow durations of one stage (us, capped at 65535) in a fixed buffer,
+//min/avg/max/p99 are computed only when they get printed.
+
+const int latencyWindow = 128;
+
+class LatencyStats
+{
+public:
+    void Add(uint32_t us) {
+      samples[head] = us > 0xFFFF ? 0xFFFF : us;
+      head = (head + 1) % latencyWindow;
+      if(count < latencyWindow) {
+        ++count;
+      }
+    }
+
+    void Reset() {
+      head = 0;
+      count = 0;
+    }
+
+    //CSV: min,avg,max,p99
+    void PrintCsv(Print &out) {
+      uint16_t sorted[latencyWindow];
+      uint32_t sum = 0;
+      for(int i = 0;i < count;++i) {
+        //INSERTION SORT, only runs once per print
+        uint16_t v = samples[i];
+        int j = i;
+        while(j > 0 && sorted[j - 1] > v) {
+          sorted[j] = sorted[j - 1];
+          --j;
+        }
+        sorted[j] = v;
+        sum += v;
+      }
+
+      if(count == 0) {
+        out.print("0,0,0,0");
+        return;
+      }
+      out.print(sorted[0]);
+      out.print(',');
+      out.print(sum / count);
+      out.print(',');
+      out.print(sorted[count - 1]);
+      out.print(',');
+      out.print(sorted[(count * 99 + 99) / 100 - 1]);
+    }
+
+private:
+    uint16_t samples[latencyWindow];
+    int head = 0;
+    int count = 0;
+};
+
+#endif
@@ -4,7 +4,6 @@
 #include <Adafruit_NeoPixel.h>
 
 uint8_t ledState = LOW;
-uint8_t oldState = HIGH;
 unsigned long previousMillis = 0;
 
 Adafruit_NeoPixel pixels(1, D1, NEO_GRB + NEO_KHZ800);
@@ -22,38 +21,103 @@ struct HSV {
   byte v; // Value (0 to 255)
 };
 
+//INTEGER HSV, hue 0-255 covers 6 regions of 42.5 steps, so the region and the position in it come from hue * 6 / 255.
+//Divides by 255 rather than shifting by 8, which keeps every channel within 1 of the float conversion.
 RGB HSVToRGB(HSV hsv) {
-  RGB rgb;
-  float h = hsv.h * 360.0 / 255.0; // Convert hue to 0-360 range
-  float s = hsv.s / 255.0;         // Convert saturation to 0-1 range
-  float v = hsv.v / 255.0;         // Convert value to 0-1 range
-
-  float c = v * s;                 // Chroma
-  float x = c * (1 - fabs(fmod(h / 60.0, 2) - 1)); // Second largest component
-  float m = v - c;
-
-  float r_prime, g_prime, b_prime;
-
-  if (h >= 0 && h < 60) {
-    r_prime = c; g_prime = x; b_prime = 0;
-  } else if (h >= 60 && h < 120) {
-    r_prime = x; g_prime = c; b_prime = 0;
-  } else if (h >= 120 && h < 180) {
-    r_prime = 0; g_prime = c; b_prime = x;
-  } else if (h >= 180 && h < 240) {
-    r_prime = 0; g_prime = x; b_prime = c;
-  } else if (h >= 240 && h < 300) {
-    r_prime = x; g_prime = 0; b_prime = c;
-  } else {
-    r_prime = c; g_prime = 0; b_prime = x;
+  if (hsv.s == 0) {
+    return {hsv.v, hsv.v, hsv.v};
   }
 
-  // Convert to 0-255 scale
-  rgb.r = (r_prime + m) * 255.0;
-  rgb.g = (g_prime + m) * 255.0;
-  rgb.b = (b_prime + m) * 255.0;
+  uint16_t sector = hsv.h * 6;
+  uint8_t region = sector / 255;
+  uint32_t remainder = sector - region * 255; // 0-254 within the region
+  if (region == 6) {
+    region = 0; // hue 255 is red again
+  }
+
+  uint8_t p = (uint32_t)hsv.v * (255 - hsv.s) / 255;
+  uint8_t q = (uint32_t)hsv.v * (255 * 255 - hsv.s * remainder) / (255 * 255);
+  uint8_t t = (uint32_t)hsv.v * (255 * 255 - hsv.s * (255 - remainder)) / (255 * 255);
+
+  switch (region) {
+    case 0:  return {hsv.v, t, p};
+    case 1:  return {q, hsv.v, p};
+    case 2:  return {p, hsv.v, t};
+    case 3:  return {p, q, hsv.v};
+    case 4:  return {t, p, hsv.v};
+    default: return {hsv.v, p, q};
+  }
+}
+
+
+//ANIMATION WAVEFORMS
+//Phases are 16 bit fractions of one period (65536 = 2*PI), they wrap around by themselves.
+//The sine table is generated at compile time and lives in flash, nothing calls sin() at runtime.
+const int ledSineBits = 8;
+const int ledSineSize = 1 << ledSineBits;
+const int16_t ledSineOne = 32767;
+
+constexpr double ledTaylorSin(double x) {
+  //x in -PI..PI
+  double term = x;
+  double sum = x;
+  for (int n = 1; n < 12; ++n) {
+    term *= -x * x / ((2 * n) * (2 * n + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+struct LedSineTable {
+  int16_t v[ledSineSize + 1]; //one extra entry so interpolation never wraps
+
+  constexpr LedSineTable() : v() {
+    const double pi = 3.14159265358979323846;
+    for (int i = 0; i <= ledSineSize; ++i) {
+      double angle = 2.0 * pi * i / ledSineSize;
+      if (angle > pi) {
+        angle -= 2.0 * pi;
+      }
+      double s = ledTaylorSin(angle) * ledSineOne;
+      v[i] = (int16_t)(s < 0 ? s - 0.5 : s + 0.5);
+    }
+  }
+};
+
+constexpr LedSineTable ledSineTable;
+static_assert(ledSineTable.v[ledSineSize / 4] == ledSineOne && ledSineTable.v[ledSineSize / 2] == 0, "sine table");
+
+//SINE OF A PHASE, -32767..32767, linear between table entries
+inline int16_t LedSine(uint16_t phase) {
+  uint16_t index = phase >> (16 - ledSineBits);
+  int32_t fraction = phase & ((1 << (16 - ledSineBits)) - 1);
+  int32_t a = ledSineTable.v[index];
+  int32_t b = ledSineTable.v[index + 1];
+  return a + (((b - a) * fraction) >> (16 - ledSineBits));
+}
 
-  return rgb;
+//a..b BY t IN 1/256 STEPS (t = 256 is b)
+inline uint8_t LedLerp(uint8_t a, uint8_t b, uint16_t t) {
+  return a + (((int16_t)b - a) * (int16_t)t >> 8);
+}
+
+//IDLE PULSE: a short flash at the top of every sine period, clamp(sin * 4 - 3, 0, 1)
+const uint16_t ledIdlePhaseStep = 104; //0.01 rad per housekeeping tick
+
+inline uint16_t LedIdlePulse(uint16_t phase) {
+  int32_t pulse = (int32_t)LedSine(phase) * 4 - 3 * (int32_t)ledSineOne;
+  pulse = constrain(pulse, 0, (int32_t)ledSineOne);
+  return (pulse * 256) / ledSineOne;
+}
+
+//BRAKE PULSE: full sine, faster the harder the brake, sin * 0.5 + 0.5
+inline uint16_t LedBrakePhaseStep(int16_t throttlePermille) {
+  //(0.005 - 0.015 * throttle) * 4 rad per tick
+  return 209 - (626L * throttlePermille) / 1000;
+}
+
+inline uint16_t LedBrakePulse(uint16_t phase) {
+  return ((int32_t)LedSine(phase) + ledSineOne) * 128 / ledSineOne;
 }
 
 
@@ -65,33 +129,59 @@ void SetupLED(int pin) {
 HSV LEDColorHSV = {60, 255, 255};
 RGB LEDColorRGB = {255, 255, 0};
 
+//PIXEL UPDATES
+//WS2812 show() keeps interrupts off while it clocks out 24 bits per pixel at 800kHz (~30us each),
+//UART bytes arriving in that time can be lost, so only push a color that differs from the one showing
+//and never more often than ledMinShowIntervalMs, whatever the caller's rate.
+const unsigned long ledMinShowIntervalMs = 20;
+
+uint32_t ledShownColor = 0;
+bool ledShownValid = false;
+unsigned long ledShowMillis = 0;
+
+//SHOW STATS, pushed updates, updates dropped (same color or too soon), time measured around show(),
+//which is the interrupts off window plus a few us of setup
+unsigned long ledShows = 0;
+unsigned long ledShowsSkipped = 0;
+unsigned long ledBlockedMicros = 0;
+
+void ShowLed(uint32_t color) {
+  unsigned long currentMillis = millis();
+  if ((ledShownValid && color == ledShownColor) || currentMillis - ledShowMillis < ledMinShowIntervalMs) {
+    ++ledShowsSkipped;
+    return;
+  }
+  pixels.setPixelColor(0, color);
+  unsigned long showMicros = micros();
+  pixels.show();
+  ledBlockedMicros += micros() - showMicros;
+  ledShownColor = color;
+  ledShownValid = true;
+  ledShowMillis = currentMillis;
+  ++ledShows;
+}
+
 void blinkLED(uint16_t blinkRate) {
     unsigned long currentMillis = millis();
 
     if (currentMillis - previousMillis >= blinkRate) {
         previousMillis = currentMillis;     // save the last time you blinked the LED
-        oldState = ledState;
         ledState ^= 1;                      // if the LED is off turn it on and vice-versa
-        //digitalWrite(ledPin, ledState);
-        if(oldState != ledState) {
-
-          //RGB rgb = HSVToRGB(LEDColorHSV);
-          RGB rgb = LEDColorRGB;
-          
-          if(ledState == LOW) {
-            pixels.setPixelColor(0, pixels.Color(0, 0, 0));
-          }
-          else {
-            pixels.setPixelColor(0, pixels.Color(rgb.r, rgb.g, rgb.b));
-          }
-          pixels.show();
-        }
+    }
+
+    //SHOWN ON EVERY CALL, ShowLed() drops it unless it changed, and a toggle held back by the rate limit still gets out
+    //RGB rgb = HSVToRGB(LEDColorHSV);
+    RGB rgb = LEDColorRGB;
+    if(ledState == LOW) {
+      ShowLed(pixels.Color(0, 0, 0));
+    }
+    else {
+      ShowLed(pixels.Color(rgb.r, rgb.g, rgb.b));
     }
 }
 
 void LightLed() {
-  pixels.setPixelColor(0, pixels.Color(LEDColorRGB.r, LEDColorRGB.g, LEDColorRGB.b));
-  pixels.show();
+  ShowLed(pixels.Color(LEDColorRGB.r, LEDColorRGB.g, LEDColorRGB.b));
 }
 
 #endif
@@ -0,0 +1,172 @@
+#ifndef OLEDDRIVER_H
+#define OLEDDRIVER_H
+
+#include <Arduino.h>
+#include <U8x8lib.h>
+
+//TILE QUEUE OLED DRIVER
+//Keeps a copy of every 8x8 tile on the screen. Drawing only writes into that copy and marks the tiles that really changed,
+//Service() then sends dirty tiles over I2C one at a time, only as long as the next one still fits in the time it's given.
+//A tile is 1/2 of a 1x2 glyph so the longest blocking transfer is halved, and a frame never has to wait for the screen.
+
+const int oledTilesX = 8;
+const int oledTilesY = 4;
+const unsigned long oledInitialTileCostUs = 650; //half a 8x13 glyph, replaced by the measured cost after the first tile
+const uint8_t oledBytesPerTile = 15;             //SSD1306 over I2C: address + 3 position commands, address + 8 data bytes, 2 control bytes
+
+class OledTileDriver
+{
+public:
+    //DRAW STATS, tiles sent over I2C and tile writes that matched the screen and never had to be sent
+    unsigned long tilesSent = 0;
+    unsigned long tilesUnchanged = 0;
+    unsigned long tileCostUs = oledInitialTileCostUs;
+
+    //BUS STATS, time spent in I2C transfers and how long the queue took from the first dirty tile to empty
+    unsigned long busMicros = 0;
+    unsigned long lastRefreshUs = 0;
+    unsigned long maxRefreshUs = 0;
+
+    void Setup(U8X8 *_display, const uint8_t *_font) {
+      display = _display;
+      font = _font;
+      memset(tiles, 0, sizeof(tiles));
+      dirty = 0; //display got cleared, matches the zeroed tiles
+    }
+
+    //GLYPH FROM THE U8X8 FONT, 1x2 fonts take 2 tiles stacked vertically
+    void DrawGlyph(uint8_t x, uint8_t y, uint8_t encoding) {
+      uint8_t first = u8x8_pgm_read(font + 0);
+      uint8_t last = u8x8_pgm_read(font + 1);
+      uint8_t tilesWide = u8x8_pgm_read(font + 2);
+      uint8_t tilesHigh = u8x8_pgm_read(font + 3);
+      uint8_t tile[8];
+
+      for(uint8_t ty = 0;ty < tilesHigh;++ty) {
+        for(uint8_t tx = 0;tx < tilesWide;++tx) {
+          if(encoding >= first && encoding <= last) {
+            //U8X8 FONT LAYOUT: 4 BYTE HEADER, THEN ALL TILES OF EACH GLYPH ROW BY ROW
+            const uint8_t *src = font + 4 + ((uint16_t)(encoding - first) * tilesWide * tilesHigh + ty * tilesWide + tx) * 8;
+            for(uint8_t i = 0;i < 8;++i) {
+              tile[i] = u8x8_pgm_read(src + i);
+            }
+          }
+          else {
+            memset(tile, 0, sizeof(tile));
+          }
+          DrawTile(x + tx, y + ty, tile);
+        }
+      }
+    }
+
+    void DrawTile(uint8_t x, uint8_t y, const uint8_t *tile) {
+      if(x >= oledTilesX || y >= oledTilesY) {
+        return;
+      }
+      if(memcmp(tiles[y][x], tile, 8) == 0) {
+        ++tilesUnchanged;
+        return;
+      }
+      memcpy(tiles[y][x], tile, 8);
+      if(!dirty) {
+        refreshStartMicros = micros();
+      }
+      dirty |= TileBit(x, y);
+    }
+
+    bool Busy() const {
+      return dirty != 0;
+    }
+
+    //SEND DIRTY TILES WHILE THE NEXT ONE FITS IN budgetUs, returns the number of tiles sent
+    int Service(unsigned long budgetUs) {
+      int sent = 0;
+      unsigned long startMicros = micros();
+      while(dirty && micros() - startMicros + tileCostUs <= budgetUs) {
+        SendNextTile();
+        ++sent;
+      }
+      return sent;
+    }
+
+    //SEND ONE TILE EVEN IF IT DOESN'T FIT, so a screen that never gets a gap still moves
+    void ServiceOne() {
+      if(dirty) {
+        SendNextTile();
+      }
+    }
+
+    //BLOCKING, SEND EVERYTHING (setup)
+    void Flush() {
+      while(dirty) {
+        SendNextTile();
+      }
+    }
+
+    unsigned long BusBytes() const {
+      return tilesSent * oledBytesPerTile;
+    }
+
+    void ResetStats() {
+      tilesSent = 0;
+      tilesUnchanged = 0;
+      busMicros = 0;
+      lastRefreshUs = 0;
+      maxRefreshUs = 0;
+    }
+
+    //WHAT SHOULD BE ON THE SCREEN AS A PLAIN PBM IMAGE (P1), paste the output into a .pbm file to look at it
+    void DumpPbm(Print &out) {
+      out.print("P1\n");
+      out.print(oledTilesX * 8);
+      out.print(' ');
+      out.print(oledTilesY * 8);
+      out.print('\n');
+      for(int py = 0;py < oledTilesY * 8;++py) {
+        for(int px = 0;px < oledTilesX * 8;++px) {
+          //TILE BYTES ARE COLUMNS, bit 0 IS THE TOP PIXEL
+          uint8_t column = tiles[py / 8][px / 8][px % 8];
+          out.print((column >> (py % 8)) & 1 ? '1' : '0');
+        }
+        out.print('\n');
+      }
+    }
+
+private:
+    U8X8 *display = nullptr;
+    const uint8_t *font = nullptr;
+    uint8_t tiles[oledTilesY][oledTilesX][8];
+    uint32_t dirty = 0; //one bit per tile, y * oledTilesX + x
+    uint8_t nextTile = 0;
+    unsigned long refreshStartMicros = 0;
+
+    static uint32_t TileBit(uint8_t x, uint8_t y) {
+      return 1UL << (y * oledTilesX + x);
+    }
+
+    void SendNextTile() {
+      //ROUND ROBIN FROM THE LAST TILE SENT, so one value changing all the time can't hold the rest of the screen back
+      while(!(dirty & (1UL << nextTile))) {
+        nextTile = (nextTile + 1) % (oledTilesX * oledTilesY);
+      }
+      uint8_t x = nextTile % oledTilesX;
+      uint8_t y = nextTile / oledTilesX;
+
+      unsigned long startMicros = micros();
+      display->drawTile(x, y, 1, tiles[y][x]);
+      unsigned long cost = micros() - startMicros;
+
+      //DECAYING PEAK OF THE TILE COST, a fast tile shouldn't make the next slow one look affordable
+      tileCostUs = max(cost, tileCostUs - tileCostUs / 16);
+      busMicros += cost;
+      dirty &= ~(1UL << nextTile);
+      ++tilesSent;
+
+      if(!dirty) {
+        lastRefreshUs = micros() - refreshStartMicros;
+        maxRefreshUs = max(maxRefreshUs, lastRefreshUs);
+      }
+    }
+};
+
+#endif
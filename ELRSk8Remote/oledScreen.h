@@ -5,43 +5,130 @@
 #include <Arduino.h>
 #include <U8x8lib.h>
 #include "batteryGlyphs.h"
+#include "oledDriver.h"
+#include "fixedFormat.h"
 
 //OLED
 //U8X8_SSD1306_64X48_ER_HW_I2C u8x8(/* reset=*/ U8X8_PIN_NONE);
 U8X8_SSD1306_64X32_1F_HW_I2C  u8x8(/* reset=*/ U8X8_PIN_NONE);
 
 
+const int screenTextWidth = 8;
+const int screenTextHeight = 2;
+
+//PAGE NUMBER FORMATS: width, decimals, input decimals, unit
+const FixedFormat voltageFormat = {5, 2, 3, "V"};
+const FixedFormat distanceKmFormat = {5, 1, 1, "km"};
+const FixedFormat distanceMiFormat = {5, 1, 1, "mi"};
+const FixedFormat speedKmFormat = {4, 1, 3, "km/h"};
+const FixedFormat speedMiFormat = {4, 1, 3, " mph"};
+const FixedFormat maxSpeedKmFormat = {3, 0, 3, "km/h"};
+const FixedFormat maxSpeedMiFormat = {3, 0, 3, " mph"};
+const FixedFormat currentFormat = {6, 1, 1, "A"};
+const FixedFormat linkQualityFormat = {4, 0, 0, "LQ"};
+const FixedFormat rssiFormat = {4, 0, 0, "rssi"};
+const FixedFormat temperatureFormat = {5, 1, 1, "C"};
+const FixedFormat wattHoursFormat = {5, 1, 1, "Wh"};
+const FixedFormat whPerKmFormat = {4, 1, 1, "Wh/k"};
+const FixedFormat whPerMiFormat = {4, 1, 1, "Wh/m"};
+const FixedFormat calibrationFormat = {5, 0, 0, ""};
+
+//VALUES A PAGE ROW CAN SHOW
+enum ScreenValues{
+  VALUE_VOLTAGE,
+  VALUE_DISTANCE,
+  VALUE_SPEED,
+  VALUE_CURRENT,
+  VALUE_LINK_QUALITY,
+  VALUE_RSSI,
+  VALUE_TEMP_ESC,
+  VALUE_TEMP_MOTOR,
+  VALUE_MAX_SPEED,
+  VALUE_MAX_CURRENT,
+  VALUE_WATT_HOURS,
+  VALUE_WH_PER_DISTANCE,
+  VALUE_THROTTLE_CALIBRATE,
+  VALUE_BATTERY_CALIBRATE,
+};
+
+//PAGE LAYOUT: a label, one value and its format per row, the miles format if it differs,
+//and the column of the remote battery glyph on the first row (-1 = none)
+struct ScreenRow {
+  uint8_t value;
+  const char *label;
+  const FixedFormat *format;
+  const FixedFormat *milesFormat;
+};
+
+struct ScreenPage {
+  ScreenRow rows[screenTextHeight];
+  int8_t batteryColumn;
+};
+
 enum ScreenModes{
   SCREEN_VOLTAGE_DISTANCE = 0,
   SCREEN_SPEED_CURRENT = 1,
   SCREEN_RC_LINK = 2,
-  SCREEN_MAX_MODES = 2,
+  SCREEN_TEMPERATURES = 3,
+  SCREEN_MAX_SPEED = 4,
+  SCREEN_ENERGY = 5,
+  SCREEN_MAX_MODES = 5,
 
   SCREEN_CALIBRATION = 100,
 };
 
-const int screenTextWidth = 8;
-const int screenTextHeight = 2;
+//ONE ENTRY PER SCREEN MODE, in button order
+const ScreenPage screenPages[] = {
+  //SCREEN_VOLTAGE_DISTANCE
+  {{{VALUE_VOLTAGE, "", &voltageFormat, nullptr},
+    {VALUE_DISTANCE, "", &distanceKmFormat, &distanceMiFormat}}, 7},
+  //SCREEN_SPEED_CURRENT
+  {{{VALUE_SPEED, "", &speedKmFormat, &speedMiFormat},
+    {VALUE_CURRENT, "", &currentFormat, nullptr}}, -1},
+  //SCREEN_RC_LINK
+  {{{VALUE_LINK_QUALITY, "", &linkQualityFormat, nullptr},
+    {VALUE_RSSI, "", &rssiFormat, nullptr}}, -1},
+  //SCREEN_TEMPERATURES
+  {{{VALUE_TEMP_ESC, "E", &temperatureFormat, nullptr},
+    {VALUE_TEMP_MOTOR, "M", &temperatureFormat, nullptr}}, -1},
+  //SCREEN_MAX_SPEED
+  {{{VALUE_MAX_SPEED, "^", &maxSpeedKmFormat, &maxSpeedMiFormat},
+    {VALUE_MAX_CURRENT, "^", &currentFormat, nullptr}}, -1},
+  //SCREEN_ENERGY
+  {{{VALUE_WATT_HOURS, "", &wattHoursFormat, nullptr},
+    {VALUE_WH_PER_DISTANCE, "", &whPerKmFormat, &whPerMiFormat}}, -1},
+};
+static_assert(sizeof(screenPages) / sizeof(screenPages[0]) == SCREEN_MAX_MODES + 1, "one page per screen mode");
+
+const ScreenPage calibrationPage =
+  {{{VALUE_THROTTLE_CALIBRATE, "thr", &calibrationFormat, nullptr},
+    {VALUE_BATTERY_CALIBRATE, "bat", &calibrationFormat, nullptr}}, -1};
 
 class OledScreenMenu
 {
 public:
+    //VALUES IN FIXED POINT, the scale is the inputDecimals of their page format
     int remoteBatteryPercent = 0;
-    float voltage = 0;
-    float current = 0;
-    float distance = 0;
-    float tempEsc = 0;
-    float tempMotor = 0;
-    float speed = 0;
-    float linkQuality = 0;
-    float rssi = 0;
-    int throttleCalibrate = 0;
-    int batteryCalibrate = 0;
+    int32_t voltage = 0;   //0.001V
+    int32_t current = 0;   //0.1A
+    int32_t distance = 0;  //0.1km/mi
+    int32_t tempEsc = 0;   //0.1C
+    int32_t tempMotor = 0; //0.1C
+    int32_t speed = 0;     //0.001km/h/mph
+    int32_t linkQuality = 0;
+    int32_t rssi = 0;
+    int32_t maxSpeed = 0;  //0.001km/h/mph
+    int32_t maxCurrent = 0; //0.1A
+    int32_t wattHours = 0; //0.1Wh
+    int32_t whPerDistance = 0; //0.1Wh/km/mi
+    int32_t throttleCalibrate = 0;
+    int32_t batteryCalibrate = 0;
     
     void Setup(int _button1Pin, int initialMode, bool useKilometers){
       u8x8.begin();
       u8x8.clear();
       u8x8.setFont(u8x8_font_8x13B_1x2_r);
+      display.Setup(&u8x8, u8x8_font_8x13B_1x2_r);
 
       button1 = _button1Pin;
       pinMode(button1, INPUT_PULLUP);
@@ -50,14 +137,15 @@ public:
       kilometers = useKilometers;
     }
 
-    void Update() {
-      //OPTIMIZED SCREEN TEXT UPDATE (~1300us)
-      //At 250HZ there's only 2000us available for screen update
-      //So I only update one character per frame, at 250hz that's 15 fps
-      //ELRS telemetry packets are way slower anyway
-
+    //TILE QUEUE BETWEEN THE PAGES AND I2C, public for its draw stats
+    OledTileDriver display;
 
-      //unsigned long currentMicros = micros();
+    //returns the number of tiles sent
+    int Update(unsigned long budgetUs) {
+      //BUDGETED SCREEN UPDATE
+      //Pages are drawn into the tile queue, which only keeps tiles that differ from what's on the screen.
+      //The page text is formatted again only when a shown value changed.
+      //Then as many tiles are sent as fit in budgetUs, the rest waits for the next call.
       
       if(needsClear) {
         for(int i = 0;i < screenTextWidth;++i) {
@@ -65,116 +153,42 @@ public:
           screenTextBuf[1][i] = ' ';
         }
         needsClear = false;
-        return;
+        formatted = false;
       }
 
-      char oldChar;
-      
-      switch(screenMode) {
-        case SCREEN_VOLTAGE_DISTANCE:
-          oldChar = screenTextBuf[screenTextY][screenTextX];
-          //VOLTAGE    
-          if(screenTextY == 0) {
-              dtostrf(voltage, 1, 2, screenTextBuf[0]);
-              screenTextBuf[0][5] = 'V';
-          }
-          if(screenTextY == 1) {
-            dtostrf(distance, 1, 1, screenTextBuf[1]);
-            if(kilometers) {
-              screenTextBuf[1][5] = 'k';
-              screenTextBuf[1][6] = 'm';
-            }
-            else {
-              screenTextBuf[1][5] = 'm';
-              screenTextBuf[1][6] = 'i';
-            }
-            
-          }
-          
-          //DRAW SINGLE SYMBOL PER UPDATE
-          if(screenTextX == 7 && screenTextY == 0) {
-            //BATTERY
-            drawBatteryTile(remoteBatteryPercent, 7, 0);
-          }
-          else {
-            //CHAR
-             u8x8.drawGlyph(screenTextX, screenTextY * 2, screenTextBuf[screenTextY][screenTextX]);
-          }
-          
-          screenTextX++;
-          if(screenTextX >= screenTextWidth) {
-            screenTextX = 0;
-            ++screenTextY;
-            if(screenTextY >= screenTextHeight) {
-              screenTextY = 0;
-            }
-          }
-        break;
-        
-        case SCREEN_SPEED_CURRENT:
-          if(screenTextY == 0) {
-              dtostrf(speed, 4, 1, screenTextBuf[0]);
-              if(kilometers) {
-                screenTextBuf[0][4] = 'k';
-                screenTextBuf[0][5] = 'm';
-                screenTextBuf[0][6] = '/';
-                screenTextBuf[0][7] = 'h';
-              }
-              else {
-                screenTextBuf[0][4] = ' ';
-                screenTextBuf[0][5] = 'm';
-                screenTextBuf[0][6] = 'p';
-                screenTextBuf[0][7] = 'h';
-              }
-          }
-          if(screenTextY == 1) {
-            dtostrf(current, 4, 1, screenTextBuf[1]);
-            screenTextBuf[1][6] = 'A';
-          }
-      
-          UpdateChar();
-      break;
-      
-        case SCREEN_RC_LINK:
-          if(screenTextY == 0) {
-              //dtostrf(linkQuality, 1, 0, screenTextBuf[0]);
-              itoa((int)linkQuality, screenTextBuf[0], 10);
-              screenTextBuf[0][5] = 'L';
-              screenTextBuf[0][6] = 'Q';
-          }
-          if(screenTextY == 1) {
-              //dtostrf(rssi, 1, 0, screenTextBuf[1]);
-              itoa((int)rssi, screenTextBuf[1], 10);
-              screenTextBuf[1][4] = 'r';
-              screenTextBuf[1][5] = 's';
-              screenTextBuf[1][6] = 's';
-              screenTextBuf[1][7] = 'i';
-          }
-          
-          UpdateChar();
-        break;
-        case SCREEN_CALIBRATION:
-          if(screenTextY == 0) {
-            //strcpy(screenTextBuf[0], "Calibrating");
-            itoa((int)throttleCalibrate, screenTextBuf[0] + 3, 10);
-            screenTextBuf[0][0] = 't';
-            screenTextBuf[0][1] = 'h';
-            screenTextBuf[0][2] = 'r';
-          }
-          if(screenTextY == 1) {
-            //itoa((int)throttleCalibrate, screenTextBuf[1], 10);
-            itoa((int)batteryCalibrate, screenTextBuf[1] + 3, 10);
-            screenTextBuf[1][0] = 'b';
-            screenTextBuf[1][1] = 'a';
-            screenTextBuf[1][2] = 't';
-          }
-          UpdateChar();
-        break;
+      int32_t values[screenTextHeight];
+      GetPageValues(values);
+      int battery = batteryIndex(remoteBatteryPercent);
+      if(!formatted || values[0] != formattedValues[0] || values[1] != formattedValues[1]) {
+        FormatPage(values);
+        formattedValues[0] = values[0];
+        formattedValues[1] = values[1];
+        formatted = true;
+        RenderPage(battery);
       }
-      
-      //Serial.println(micros() - currentMicros);
+      else if(battery != renderedBatteryIndex) {
+        RenderPage(battery);
+      }
+
+      int sent = display.Service(budgetUs);
     
       UpdateButton1();
+      return sent;
+    }
+
+    //DRAW THE WHOLE PAGE RIGHT NOW, blocking (setup)
+    void Flush() {
+      Update(0);
+      display.Flush();
+    }
+
+    int Mode() {
+      return screenMode;
+    }
+
+    void SetMode(int mode) {
+      screenMode = mode;
+      needsClear = true;
     }
 
     void UpdateButton1() {
@@ -205,9 +219,9 @@ public:
 private:
     //SCREEN UPDATE
     char screenTextBuf[screenTextHeight][screenTextWidth + 8];
-    int screenTextX = 0;
-    int screenTextY = 0;
-    bool doDrawBattery = false;
+    int renderedBatteryIndex = -1;
+    int32_t formattedValues[screenTextHeight];
+    bool formatted = false;
     bool kilometers = false;
     
     //SCREEN PAGES
@@ -222,19 +236,83 @@ private:
     unsigned long debounceDelay = 5;
 
 
-    void UpdateChar() {
-      u8x8.drawGlyph(screenTextX, screenTextY * 2, screenTextBuf[screenTextY][screenTextX]);
-      screenTextX++;
-      if(screenTextX >= screenTextWidth) {
-        screenTextX = 0;
-        ++screenTextY;
-        if(screenTextY >= screenTextHeight) {
-          screenTextY = 0;
+    const ScreenPage &CurrentPage() {
+      if(screenMode == SCREEN_CALIBRATION || screenMode < 0 || screenMode > SCREEN_MAX_MODES) {
+        return calibrationPage;
+      }
+      return screenPages[screenMode];
+    }
+
+    bool IsBatteryCell(int x, int y) {
+      return y == 0 && x == CurrentPage().batteryColumn;
+    }
+
+    int32_t GetValue(uint8_t value) {
+      switch(value) {
+        case VALUE_VOLTAGE: return voltage;
+        case VALUE_DISTANCE: return distance;
+        case VALUE_SPEED: return speed;
+        case VALUE_CURRENT: return current;
+        case VALUE_LINK_QUALITY: return linkQuality;
+        case VALUE_RSSI: return rssi;
+        case VALUE_TEMP_ESC: return tempEsc;
+        case VALUE_TEMP_MOTOR: return tempMotor;
+        case VALUE_MAX_SPEED: return maxSpeed;
+        case VALUE_MAX_CURRENT: return maxCurrent;
+        case VALUE_WATT_HOURS: return wattHours;
+        case VALUE_WH_PER_DISTANCE: return whPerDistance;
+        case VALUE_THROTTLE_CALIBRATE: return throttleCalibrate;
+        case VALUE_BATTERY_CALIBRATE: return batteryCalibrate;
+      }
+      return 0;
+    }
+
+    //VALUES SHOWN ON THE CURRENT PAGE, one per row
+    void GetPageValues(int32_t values[]) {
+      const ScreenPage &page = CurrentPage();
+      for(int y = 0;y < screenTextHeight;++y) {
+        values[y] = GetValue(page.rows[y].value);
+      }
+    }
+
+    void FormatPage(const int32_t values[]) {
+      const ScreenPage &page = CurrentPage();
+      for(int y = 0;y < screenTextHeight;++y) {
+        const ScreenRow &row = page.rows[y];
+        const FixedFormat &format = (!kilometers && row.milesFormat) ? *row.milesFormat : *row.format;
+        FormatRow(y, values[y], format, row.label);
+      }
+    }
+
+    //ONE ROW: optional label, the number, then blanks up to the screen width
+    void FormatRow(int row, int32_t value, const FixedFormat &format, const char *label = "") {
+      char *text = screenTextBuf[row];
+      int pos = 0;
+      while(*label && pos < screenTextWidth) {
+        text[pos++] = *label++;
+      }
+      pos += formatFixed(text + pos, value, format);
+      while(pos < screenTextWidth) {
+        text[pos++] = ' ';
+      }
+    }
+
+    //WRITE EVERY CELL OF THE PAGE INTO THE TILE QUEUE, unchanged tiles are dropped there
+    void RenderPage(int battery) {
+      for(int y = 0;y < screenTextHeight;++y) {
+        for(int x = 0;x < screenTextWidth;++x) {
+          if(IsBatteryCell(x, y)) {
+            drawBatteryTile(battery, x, y * 2);
+          }
+          else {
+            display.DrawGlyph(x, y * 2, screenTextBuf[y][x]);
+          }
         }
       }
+      renderedBatteryIndex = battery;
     }
     
-    void drawBatteryTile(int level, int x, int y) {
+    int batteryIndex(int level) {
       int index = level / 10;
       if (index > 9) {
         index = 9;
@@ -244,9 +322,13 @@ private:
           index = 0;
         }  
       }
+      return index;
+    }
+
+    void drawBatteryTile(int index, int x, int y) {
       //DRAW 2 8x8 TILES VERTICALLY STACKED
-      u8x8.drawTile(x, y, 1, (uint8_t*)(&batteryGlyphs[index])); // Top tile
-      u8x8.drawTile(x, y + 1, 1, (uint8_t*)(&batteryGlyphs[index]) + 8); // Bottom tile
+      display.DrawTile(x, y, (const uint8_t*)(&batteryGlyphs[index])); // Top tile
+      display.DrawTile(x, y + 1, (const uint8_t*)(&batteryGlyphs[index]) + 8); // Bottom tile
     }
 };
 
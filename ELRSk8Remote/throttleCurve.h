@@ -0,0 +1,90 @@
+#ifndef THROTTLECURVE_H
+#define THROTTLECURVE_H
+
+#include <Arduino.h>
+
+//THROTTLE AND BRAKE CURVES
+//Built once from the calibration (low/mid/high ADC) into two tables of channel values at equally spaced ADC points,
+//one from throttleLow to throttleMid (brake), one from throttleMid to throttleHigh (throttle).
+//Sending a frame is one table read and an integer interpolation, no float.
+//Curves are expo (0 linear .. 100 cubic), a deadband around mid in percent of each side's travel,
+//and a limit on how far full brake goes, in percent of the brake half. Ends are exact: low -> min (at 100% brake), mid -> mid, high -> max.
+
+const int throttleCurveSegments = 32;
+
+struct ThrottleCurveConfig {
+  uint8_t throttleExpo;
+  uint8_t brakeExpo;
+  uint8_t deadband;
+  uint8_t maxBrake;
+};
+
+class ThrottleCurve
+{
+public:
+    void Build(int _adcLow, int _adcMid, int _adcHigh, int16_t outMin, int16_t outMid, int16_t outMax, const ThrottleCurveConfig &config) {
+      adcLow = _adcLow;
+      adcMid = _adcMid;
+      adcHigh = _adcHigh;
+
+      int16_t brakeEnd = outMid - (int16_t)(((int32_t)(outMid - outMin) * config.maxBrake + 50) / 100);
+      for(int i = 0;i <= throttleCurveSegments;++i) {
+        //BRAKE TABLE STARTS AT FULL BRAKE (adcLow)
+        float travel = (float)(throttleCurveSegments - i) / throttleCurveSegments;
+        brake[i] = Point(travel, config.brakeExpo, config.deadband, outMid, brakeEnd);
+        throttle[i] = Point((float)i / throttleCurveSegments, config.throttleExpo, config.deadband, outMid, outMax);
+      }
+      built = true;
+    }
+
+    bool Matches(int _adcLow, int _adcMid, int _adcHigh) const {
+      return built && adcLow == _adcLow && adcMid == _adcMid && adcHigh == _adcHigh;
+    }
+
+    //ALL THREE POINTS WITHIN tolerance OF THE ONES THE TABLES WERE BUILT FROM
+    bool Near(int _adcLow, int _adcMid, int _adcHigh, int tolerance) const {
+      return built && abs(adcLow - _adcLow) <= tolerance && abs(adcMid - _adcMid) <= tolerance && abs(adcHigh - _adcHigh) <= tolerance;
+    }
+
+    int16_t Map(int adc) const {
+      if(adc < adcMid) {
+        return Lookup(brake, adc - adcLow, adcMid - adcLow);
+      }
+      return Lookup(throttle, adc - adcMid, adcHigh - adcMid);
+    }
+
+private:
+    int adcLow = 0;
+    int adcMid = 0;
+    int adcHigh = 0;
+    bool built = false;
+    int16_t brake[throttleCurveSegments + 1];
+    int16_t throttle[throttleCurveSegments + 1];
+
+    //ONE TABLE POINT, travel 0 (mid) .. 1 (end of this side)
+    static int16_t Point(float travel, uint8_t expo, uint8_t deadband, int16_t from, int16_t to) {
+      float d = deadband * 0.01f;
+      float x = travel <= d ? 0.0f : (travel - d) / (1.0f - d);
+      float e = expo * 0.01f;
+      float y = (1.0f - e) * x + e * x * x * x;
+      return from + (int16_t)lroundf(y * (to - from));
+    }
+
+    //LINEAR BETWEEN THE TWO TABLE POINTS AROUND pos, tables rise from index 0 to the last one
+    static int16_t Lookup(const int16_t table[], int32_t pos, int32_t span) {
+      if(pos <= 0 || span <= 0) {
+        return table[0];
+      }
+      if(pos >= span) {
+        return table[throttleCurveSegments];
+      }
+      int32_t scaled = pos * throttleCurveSegments;
+      int32_t index = scaled / span;
+      int32_t fraction = scaled - index * span;
+      int32_t a = table[index];
+      int32_t b = table[index + 1];
+      return a + ((b - a) * fraction + span / 2) / span;
+    }
+};
+
+#endif
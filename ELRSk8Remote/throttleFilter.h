@@ -0,0 +1,130 @@
+#ifndef THROTTLEFILTER_H
+#define THROTTLEFILTER_H
+
+#include <Arduino.h>
+
+//THROTTLE INPUT FILTER
+//The ADC is sampled in the background from loop() at a fixed rate, every sample goes through the selected filter
+//and the result is kept ready, so sending a frame only reads Value() and never waits for the ADC.
+
+enum ThrottleFilterModes{
+  THROTTLE_FILTER_NONE = 0,           //last sample
+  THROTTLE_FILTER_MOVING_AVERAGE = 1, //mean of the last throttleFilterWindow samples
+  THROTTLE_FILTER_MEDIAN = 2,         //median of the last throttleMedianSize samples, drops single spikes without smearing steps
+  THROTTLE_FILTER_ONE_EURO = 3,       //adaptive low pass: heavy smoothing when the trigger is still, little lag when it moves
+};
+
+const int throttleFilterWindow = 8;
+const int throttleMedianSize = 5;
+static_assert(throttleMedianSize <= throttleFilterWindow, "median comes from the sample history");
+
+//ONE EURO FILTER TUNING (Casiez et al.), cutoff in Hz, beta per ADC unit/s
+const float throttleOneEuroMinCutoff = 5.0f;
+const float throttleOneEuroBeta = 0.002f;
+const float throttleOneEuroDerivativeCutoff = 10.0f;
+
+class ThrottleFilter
+{
+public:
+    unsigned long samples = 0;
+
+    void Setup(int _mode, uint32_t _sampleIntervalUs, int firstSample) {
+      mode = _mode;
+      sampleIntervalUs = _sampleIntervalUs;
+      Reset(firstSample);
+    }
+
+    void Reset(int sample) {
+      for(int i = 0;i < throttleFilterWindow;++i) {
+        history[i] = sample;
+      }
+      sum = (int32_t)sample * throttleFilterWindow;
+      head = 0;
+      value = sample;
+      euroValue = sample;
+      euroDerivative = 0;
+    }
+
+    //True when a new sample is due, call as often as possible from loop()
+    bool Due(uint32_t now) {
+      if(now - lastSampleMicros < sampleIntervalUs) {
+        return false;
+      }
+      lastSampleMicros = now;
+      return true;
+    }
+
+    void AddSample(int sample) {
+      ++samples;
+      sum += sample - history[head];
+      history[head] = sample;
+      head = (head + 1) % throttleFilterWindow;
+
+      switch(mode) {
+        case THROTTLE_FILTER_MOVING_AVERAGE:
+          value = (sum + throttleFilterWindow / 2) / throttleFilterWindow;
+        break;
+        case THROTTLE_FILTER_MEDIAN:
+          value = Median();
+        break;
+        case THROTTLE_FILTER_ONE_EURO:
+          value = OneEuro(sample);
+        break;
+        default:
+          value = sample;
+        break;
+      }
+    }
+
+    //Latest filtered throttle in ADC units
+    int Value() const {
+      return value;
+    }
+
+    //When the latest sample was taken
+    uint32_t SampleMicros() const {
+      return lastSampleMicros;
+    }
+
+private:
+    int mode = THROTTLE_FILTER_NONE;
+    uint32_t sampleIntervalUs = 1000;
+    uint32_t lastSampleMicros = 0;
+    int history[throttleFilterWindow];
+    int32_t sum = 0;
+    int head = 0;
+    int value = 0;
+    float euroValue = 0;
+    float euroDerivative = 0;
+
+    int Median() {
+      //INSERTION SORT OF THE NEWEST SAMPLES, 5 values is a handful of compares
+      int sorted[throttleMedianSize];
+      for(int i = 0;i < throttleMedianSize;++i) {
+        int sample = history[(head + throttleFilterWindow - 1 - i) % throttleFilterWindow];
+        int j = i;
+        while(j > 0 && sorted[j - 1] > sample) {
+          sorted[j] = sorted[j - 1];
+          --j;
+        }
+        sorted[j] = sample;
+      }
+      return sorted[throttleMedianSize / 2];
+    }
+
+    static float Alpha(float cutoff, float dt) {
+      float tau = 1.0f / (2.0f * PI * cutoff);
+      return 1.0f / (1.0f + tau / dt);
+    }
+
+    int OneEuro(int sample) {
+      float dt = sampleIntervalUs * 1e-6f;
+      float derivative = (sample - euroValue) / dt;
+      euroDerivative += Alpha(throttleOneEuroDerivativeCutoff, dt) * (derivative - euroDerivative);
+      float cutoff = throttleOneEuroMinCutoff + throttleOneEuroBeta * fabsf(euroDerivative);
+      euroValue += Alpha(cutoff, dt) * (sample - euroValue);
+      return (int)(euroValue + 0.5f);
+    }
+};
+
+#endif
@@ -1,11 +1,11 @@
-#include <VescUart.h>
 #include <SimpleKalmanFilter.h>
 #include <stdio.h>
 #include "crsfTelemetry.h"
+#include "vescPoller.h"
+#include "telemetryScheduler.h"
 #include <Arduino.h>
 
 //REQUIRED LIBRARIES:
-//VescUart
 //AlfredoCRSF
 //SimpleKalmanFilter
 
@@ -45,16 +45,32 @@ float motorPulleyTeeth = 15;
 float wheelPulleyTeeth = 40;
 int motorMagnets = 14;
 
+uint32_t vescPollIntervalMs = 10; //new VESC values at most this often
+uint32_t vescTimeoutMs = 50;      //ask again if a reply hasn't fully arrived by then
+//ONLY THE VESC VALUES THE TELEMETRY USES, a shorter reply means fresher values (VESC_VALUES_ALL for everything)
+uint32_t vescValuesMask = VESC_VALUE_TEMP_MOSFET | VESC_VALUE_TEMP_MOTOR | VESC_VALUE_INPUT_CURRENT | VESC_VALUE_RPM |
+                          VESC_VALUE_INPUT_VOLTAGE | VESC_VALUE_WATT_HOURS | VESC_VALUE_TACHOMETER_ABS;
+
+//TELEMETRY, set the same packet rate (Hz) and telemetry ratio (1:N) as the remote, frames are sent only as fast as the downlink carries them
+//MUST MATCH ELRSpacketRate / ELRStelemetryRate IN ELRSk8Remote.ino (250Hz = 3, 1:32 = 4), link statistics don't carry the ratio so they can't be read here
+uint16_t ELRSpacketRateHz = 250;
+uint8_t ELRStelemetryRatio = 32;
+uint8_t telemetryPacketsPerFrame = 2; //downlink packets one telemetry frame takes
+//HOW OFTEN EACH FRAME GOES OUT RELATIVE TO THE OTHERS: ride (speed, current, voltage, temps, Wh, distance) / max values / Wh per km
+uint8_t telemetryWeights[TELEMETRY_SLOT_COUNT] = {4, 1, 1};
+//DELTA RIDE FRAMES, a full keyframe every this many ride frames and only the changes in between (0 = always full frames)
+uint8_t telemetryKeyframeInterval = 8;
+
 //END CONFIG////////////////////////
 
 
-VescUart VESCUART;
+VescPoller vesc;
+TelemetryScheduler telemetryScheduler;
 //TELEMETRY DATA
 int rpm;
 float voltage;
 float current;
 int power;
-float amphour;
 float tach;
 float distance;
 float velocity;
@@ -63,10 +79,10 @@ float batpercentage;
 float tempEsc;
 float tempMotor;
 float whkm = 0;
+float cellVoltage = 0;
 //MAX VALUES
 float maxA = 0;
 float maxVel = 0;
-float maxTemp = 0;
 //filters
 SimpleKalmanFilter cellVoltageFilter(0.01f, 0.01f, 0.01f);
 SimpleKalmanFilter escTempFilter(0.1f, 0.1f, 0.1f);
@@ -82,30 +98,10 @@ void setup() {
   
   //VESC SETUP
   VESCSerial.begin(115200);
-  VESCUART.setSerialPort(&VESCSerial);
+  vesc.begin(VESCSerial, vescPollIntervalMs, vescTimeoutMs, vescValuesMask);
+  telemetryScheduler.begin(ELRSpacketRateHz, ELRStelemetryRatio, telemetryPacketsPerFrame, telemetryWeights);
 }
 
-//VESC DATA FOR REFERENCE
-//struct dataPackage {
-//  float avgMotorCurrent;
-//  float avgInputCurrent;
-//  float dutyCycleNow;
-//  float rpm;
-//  float inpVoltage;
-//  float ampHours;
-//  float ampHoursCharged;
-//  float wattHours;
-//  float wattHoursCharged;
-//  long tachometer;
-//  long tachometerAbs;
-//  float tempMosfet;
-//  float tempMotor;
-//  float pidPos;
-//  uint8_t id;
-//  mc_fault_code error; 
-//};
-
-
 #ifdef KILOMETERS
   float metersPerMILEKM = 1.0f / 1000.0f;
 #else
@@ -114,33 +110,57 @@ void setup() {
 float wheelDiameterM = wheelDiameterMM / 1000.0f;
 float gearingRatio = motorPulleyTeeth / wheelPulleyTeeth;
 
-void loop()
+void UpdateValues()
 {
-  bool gotValues = VESCUART.getVescValues();
-
   int polePairs = motorMagnets / 2;
-  rpm = VESCUART.data.rpm / polePairs;
-  voltage = VESCUART.data.inpVoltage;
-  current = VESCUART.data.avgInputCurrent;
+  rpm = vesc.data.rpm / polePairs;
+  voltage = vesc.data.inpVoltage;
+  current = vesc.data.avgInputCurrent;
   power = voltage * current;
-  tempEsc = escTempFilter.updateEstimate(VESCUART.data.tempMosfet);
-  tempMotor = motorTempFilter.updateEstimate(VESCUART.data.tempMotor);
-  amphour = VESCUART.data.ampHours;
-  watthour = VESCUART.data.wattHours;
-  tach = VESCUART.data.tachometerAbs / (motorMagnets * 3);
+  tempEsc = escTempFilter.updateEstimate(vesc.data.tempMosfet);
+  tempMotor = motorTempFilter.updateEstimate(vesc.data.tempMotor);
+  watthour = vesc.data.wattHours;
+  tach = vesc.data.tachometerAbs / (motorMagnets * 3);
 
   distance = tach * 3.14159265f * metersPerMILEKM * wheelDiameterM * gearingRatio;       // Motor RPM x Pi x (1 / meters in a mile or km) x Wheel diameter x (motor pulley / wheelpulley)
   velocity = rpm * 3.14159265f * (60.0f * metersPerMILEKM) * wheelDiameterM * gearingRatio;  // Motor RPM x Pi x (seconds in a minute / meters in a mile) x Wheel diameter x (motor pulley / wheelpulley)
   //batpercentage = (((voltage - numCells * 3.3) / numCells) + 0.04f) * 100.0f;                     // ((Battery voltage - minimum voltage) / number of cells) x 100
+  whkm = distance > 0.01f ? watthour / distance : 0;
 
   maxVel = max(maxVel, velocity);
-  maxTemp = max(maxTemp, velocity);
-  
-  float cellVoltage = cellVoltageFilter.updateEstimate(voltage / 12.0f);
+  maxA = max(maxA, current);
   
-  //SEND TELEMETRY
+  cellVoltage = cellVoltageFilter.updateEstimate(voltage / 12.0f);
+}
+
+void loop()
+{
+  //CRSF IS SERVICED ON EVERY PASS, the VESC reply is picked up a few bytes at a time in between
   crsf.update();
-  sendRxBattery(cellVoltage * 100, velocity * 100, distance * 10, current * 5);
-  
-  delay(10);
+
+  if(vesc.update()) {
+    UpdateValues();
+  }
+
+  if(vesc.replies == 0) {
+    return; //nothing worth sending yet
+  }
+
+  //SEND TELEMETRY, one frame whenever the downlink has room for it, fast changing values most often
+  switch(telemetryScheduler.next()) {
+    case TELEMETRY_SLOT_RIDE:
+      if(telemetryKeyframeInterval > 0) {
+        sendRideDelta(velocity, current, cellVoltage, tempEsc, tempMotor, watthour, distance, telemetryKeyframeInterval);
+      }
+      else {
+        sendRidePacked(velocity, current, cellVoltage, tempEsc, tempMotor, watthour, distance);
+      }
+    break;
+    case TELEMETRY_SLOT_TOTALS:
+      sendRideTotals(maxVel, maxA);
+    break;
+    case TELEMETRY_SLOT_EFFICIENCY:
+      sendRideEfficiency(whkm, power);
+    break;
+  }
 }
@@ -82,4 +82,161 @@ void sendRxBattery(float voltage, float current, float capacity, float remaining
   crsf.queuePacket(CRSF_SYNC_BYTE, CRSF_FRAMETYPE_BATTERY_SENSOR, &crsfBatt, sizeof(crsfBatt));
   
 }
+
+//ELRSK8 RIDE FRAME
+//Every ride value in one frame: ArduPilot passthrough type (ELRS forwards it) with an extended header and our own subtype,
+//then the fields bit packed MSB first, out of range values are clamped:
+//speed 0.1km/h/mph signed 12 bits, current 0.1A signed 12, cell voltage mV 13, ESC and motor temp 0.5C from -20C 9 each
+//(up to 235.5C, 8 bits stopped at 107.5C which a hot motor reaches), Wh used 0.1Wh 16, distance 0.01km/mi 20 = 91 bits in 12 bytes.
+//The remote decodes it in CRSF::packetArdupilot.
+#define ELRSK8_FRAMETYPE_ARDUPILOT_RESP 0x80
+#define ELRSK8_RIDE_SUBTYPE 0x4B
+#define ELRSK8_RIDE_KEY_SUBTYPE 0x4C   //keyframe sequence, then the packed fields
+#define ELRSK8_RIDE_DELTA_SUBTYPE 0x4D //keyframe sequence, then each field's change since that keyframe
+#define ELRSK8_RIDE_PACKED_LEN 12
+#define ELRSK8_RIDE_FIELDS 7
+
+//FIELD SCALING: (value + offset) * scale, bits negative for signed fields
+struct rideField_t {
+  float scale;
+  float offset;
+  int8_t bits;
+};
+const rideField_t rideFields[ELRSK8_RIDE_FIELDS] = {{10, 0, -12}, {10, 0, -12}, {1000, 0, 13}, {2, 20, 9}, {2, 20, 9}, {10, 0, 16}, {100, 0, 20}};
+
+class BitPacker {
+public:
+  BitPacker(uint8_t *buffer, uint8_t length) : buf(buffer) {
+    memset(buf, 0, length);
+  }
+
+  //Low width bits of value, MSB first
+  void put(uint32_t value, uint8_t width) {
+    for (int8_t i = width - 1; i >= 0; i--, pos++) {
+      if (value & (1UL << i)) {
+        buf[pos >> 3] |= 0x80 >> (pos & 7);
+      }
+    }
+  }
+
+private:
+  uint8_t *buf;
+  uint16_t pos = 0;
+};
+
+//RIDE VALUES TO THE INTEGERS THAT GET PACKED, rounded and clamped to what each field holds
+void quantizeRide(const float values[ELRSK8_RIDE_FIELDS], int32_t raw[ELRSK8_RIDE_FIELDS])
+{
+  for (int i = 0; i < ELRSK8_RIDE_FIELDS; i++) {
+    int8_t bits = rideFields[i].bits;
+    int32_t lo = bits < 0 ? -(1L << (-bits - 1)) : 0;
+    int32_t hi = bits < 0 ? (1L << (-bits - 1)) - 1 : (1L << bits) - 1;
+    raw[i] = constrain(lroundf((values[i] + rideFields[i].offset) * rideFields[i].scale), lo, hi);
+  }
+}
+
+void packRide(uint8_t *buf, const int32_t raw[ELRSK8_RIDE_FIELDS])
+{
+  BitPacker packer(buf, ELRSK8_RIDE_PACKED_LEN);
+  for (int i = 0; i < ELRSK8_RIDE_FIELDS; i++) {
+    packer.put((uint32_t)raw[i], abs(rideFields[i].bits));
+  }
+}
+
+void sendRidePacked(float speed, float current, float cellVoltage, float tempEsc, float tempMotor, float wattHours, float distance)
+{
+  float values[ELRSK8_RIDE_FIELDS] = {speed, current, cellVoltage, tempEsc, tempMotor, wattHours, distance};
+  int32_t raw[ELRSK8_RIDE_FIELDS];
+  quantizeRide(values, raw);
+
+  uint8_t frame[3 + ELRSK8_RIDE_PACKED_LEN];
+  frame[0] = CRSF_ADDRESS_RADIO_TRANSMITTER;
+  frame[1] = CRSF_ADDRESS_FLIGHT_CONTROLLER;
+  frame[2] = ELRSK8_RIDE_SUBTYPE;
+  packRide(&frame[3], raw);
+  crsf.queuePacket(CRSF_SYNC_BYTE, ELRSK8_FRAMETYPE_ARDUPILOT_RESP, frame, sizeof(frame));
+}
+
+//ELRSK8 RIDE DELTAS
+//Most ride values barely move from one frame to the next. A keyframe (sequence + the packed fields) goes out every
+//keyframeInterval ride frames and while/after the link is down, the frames in between only carry how far each packed field moved
+//since that keyframe as zigzag varints: 1 byte per field within +-63 steps. Deltas of a keyframe the remote missed are dropped there,
+//losing a delta loses nothing else. A delta that wouldn't be smaller than a keyframe is sent as a keyframe.
+int32_t rideKey[ELRSK8_RIDE_FIELDS];
+uint8_t rideKeySeq = 0;
+uint8_t rideFramesSinceKey = 0;
+bool rideKeyDue = true;
+
+//Zigzag varint, 7 bits per byte, low bits first, returns the bytes written
+uint8_t putVarint(uint8_t *buf, int32_t value)
+{
+  uint32_t v = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+  uint8_t len = 0;
+  while (v >= 0x80) {
+    buf[len++] = (uint8_t)v | 0x80;
+    v >>= 7;
+  }
+  buf[len++] = (uint8_t)v;
+  return len;
+}
+
+void sendRideDelta(float speed, float current, float cellVoltage, float tempEsc, float tempMotor, float wattHours, float distance, uint8_t keyframeInterval)
+{
+  float values[ELRSK8_RIDE_FIELDS] = {speed, current, cellVoltage, tempEsc, tempMotor, wattHours, distance};
+  int32_t raw[ELRSK8_RIDE_FIELDS];
+  quantizeRide(values, raw);
+
+  uint8_t frame[4 + ELRSK8_RIDE_FIELDS * 5];
+  frame[0] = CRSF_ADDRESS_RADIO_TRANSMITTER;
+  frame[1] = CRSF_ADDRESS_FLIGHT_CONTROLLER;
+  uint8_t len = 4;
+
+  bool linkUp = crsf.isLinkUp();
+  if (!rideKeyDue && rideFramesSinceKey < keyframeInterval) {
+    for (int i = 0; i < ELRSK8_RIDE_FIELDS; i++) {
+      len += putVarint(&frame[len], raw[i] - rideKey[i]);
+    }
+  }
+
+  if (len == 4 || len >= 4 + ELRSK8_RIDE_PACKED_LEN) {
+    //KEYFRAME, the deltas after it refer to these values
+    rideKeySeq++;
+    memcpy(rideKey, raw, sizeof(rideKey));
+    rideFramesSinceKey = 0;
+    frame[2] = ELRSK8_RIDE_KEY_SUBTYPE;
+    packRide(&frame[4], raw);
+    len = 4 + ELRSK8_RIDE_PACKED_LEN;
+  }
+  else {
+    frame[2] = ELRSK8_RIDE_DELTA_SUBTYPE;
+  }
+  frame[3] = rideKeySeq;
+  rideFramesSinceKey++;
+  //A KEYFRAME SENT WITHOUT A LINK NEVER ARRIVES, keep sending them until the link is back
+  rideKeyDue = !linkUp;
+
+  crsf.queuePacket(CRSF_SYNC_BYTE, ELRSK8_FRAMETYPE_ARDUPILOT_RESP, frame, len);
+}
+
+//ELRSK8 SLOW TELEMETRY
+//The remote reads these standard frames with its own layout, all fixed point, MSB first:
+//GPS       groundspeed = max speed 0.1km/h/mph, heading = max current 0.1A, the other fields stay 0
+//BARO      altitude = Wh per km/mi 0.1Wh, verticalspd = power W
+void sendRideTotals(float maxSpeed, float maxCurrent)
+{
+  crsf_sensor_gps_t crsfGps = { 0 };
+
+  crsfGps.groundspeed = htobe16((uint16_t)(maxSpeed * 10.0f));
+  crsfGps.heading = htobe16((uint16_t)(maxCurrent * 10.0f));
+  crsf.queuePacket(CRSF_SYNC_BYTE, CRSF_FRAMETYPE_GPS, &crsfGps, sizeof(crsfGps));
+}
+
+void sendRideEfficiency(float whPerDistance, int power)
+{
+  crsf_sensor_baro_altitude_t crsfBaroAltitude = { 0 };
+
+  crsfBaroAltitude.altitude = htobe16((uint16_t)(whPerDistance * 10.0f));
+  crsfBaroAltitude.verticalspd = htobe16((int16_t)power);
+  crsf.queuePacket(CRSF_SYNC_BYTE, CRSF_FRAMETYPE_BARO_ALTITUDE, &crsfBaroAltitude, sizeof(crsfBaroAltitude));
+}
 #endif
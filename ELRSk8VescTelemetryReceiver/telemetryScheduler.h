@@ -0,0 +1,66 @@
+#ifndef TELEMETRYSCHEDULER_H
+#define TELEMETRYSCHEDULER_H
+
+#include <Arduino.h>
+
+//TELEMETRY FRAME SCHEDULER
+//ELRS only has so many downlink slots (packet rate / telemetry ratio), anything queued faster just waits or gets dropped.
+//Frames are sent at the rate the link can carry, and which frame goes next is picked by weight:
+//smooth weighted round robin, each slot gains its weight every frame and the richest one is sent and pays the total,
+//so a weight 4 slot goes out 4 times as often as a weight 1 slot and they interleave evenly (R R T R E R ...).
+
+enum telemetrySlot_e {
+  TELEMETRY_SLOT_RIDE,       //speed, current, cell voltage, temps, Wh, distance - packed ride frame
+  TELEMETRY_SLOT_TOTALS,     //trip distance, Ah, max speed/current/temp - GPS frame
+  TELEMETRY_SLOT_EFFICIENCY, //Wh per km/mi - baro frame
+  TELEMETRY_SLOT_COUNT,
+};
+
+class TelemetryScheduler {
+public:
+  //rate and ratio are the ELRS settings of the remote, packetsPerFrame is how many downlink packets one of our frames takes
+  void begin(uint16_t packetRateHz, uint8_t telemetryRatio, uint8_t packetsPerFrame, const uint8_t slotWeights[TELEMETRY_SLOT_COUNT]) {
+    uint32_t framesPerSecondX100 = (uint32_t)packetRateHz * 100 / telemetryRatio / packetsPerFrame;
+    intervalMs = framesPerSecondX100 > 0 ? 100000UL / framesPerSecondX100 : 1000;
+    intervalMs = constrain(intervalMs, 10UL, 1000UL);
+
+    totalWeight = 0;
+    for (int i = 0; i < TELEMETRY_SLOT_COUNT; i++) {
+      weights[i] = slotWeights[i];
+      credits[i] = 0;
+      totalWeight += weights[i];
+    }
+  }
+
+  //Returns the slot to send now, or -1 when it isn't time for a frame yet
+  int next() {
+    uint32_t now = millis();
+    if (totalWeight == 0 || now - lastFrameMillis < intervalMs) {
+      return -1;
+    }
+    lastFrameMillis = now;
+
+    int best = 0;
+    for (int i = 0; i < TELEMETRY_SLOT_COUNT; i++) {
+      credits[i] += weights[i];
+      if (credits[i] > credits[best]) {
+        best = i;
+      }
+    }
+    credits[best] -= totalWeight;
+    return best;
+  }
+
+  uint32_t frameIntervalMs() const {
+    return intervalMs;
+  }
+
+private:
+  uint8_t weights[TELEMETRY_SLOT_COUNT];
+  int16_t credits[TELEMETRY_SLOT_COUNT];
+  int16_t totalWeight = 0;
+  uint32_t intervalMs = 1000;
+  uint32_t lastFrameMillis = 0;
+};
+
+#endif
@@ -0,0 +1,320 @@
+#ifndef VESCPOLLER_H
+#define VESCPOLLER_H
+
+#include <Arduino.h>
+
+//NON-BLOCKING VESC POLLING
+//Sends COMM_GET_VALUES_SELECTIVE (or COMM_GET_VALUES) and returns right away, the reply is parsed byte by byte from whatever has arrived
+//on each update() call, so the loop never waits for the ~65 byte reply at 115200 baud (~6ms).
+//Packet format: 0x02 len payload crc16(hi lo) 0x03, or 0x03 lenHi lenLo ... for payloads over 255 bytes.
+
+#define VESC_COMM_GET_VALUES 4
+#define VESC_COMM_GET_VALUES_SELECTIVE 50
+#define VESC_PACKET_MAX_PAYLOAD 96
+#define VESC_SELECTIVE_MAX_MISSES 3 // firmware without COMM_GET_VALUES_SELECTIVE doesn't answer, fall back to the full values after this many timeouts
+
+//COMM_GET_VALUES_SELECTIVE MASK BITS, in the order the fields come in both replies
+#define VESC_VALUE_TEMP_MOSFET        (1UL << 0)
+#define VESC_VALUE_TEMP_MOTOR         (1UL << 1)
+#define VESC_VALUE_MOTOR_CURRENT      (1UL << 2)
+#define VESC_VALUE_INPUT_CURRENT      (1UL << 3)
+#define VESC_VALUE_ID                 (1UL << 4)
+#define VESC_VALUE_IQ                 (1UL << 5)
+#define VESC_VALUE_DUTY               (1UL << 6)
+#define VESC_VALUE_RPM                (1UL << 7)
+#define VESC_VALUE_INPUT_VOLTAGE      (1UL << 8)
+#define VESC_VALUE_AMP_HOURS          (1UL << 9)
+#define VESC_VALUE_AMP_HOURS_CHARGED  (1UL << 10)
+#define VESC_VALUE_WATT_HOURS         (1UL << 11)
+#define VESC_VALUE_WATT_HOURS_CHARGED (1UL << 12)
+#define VESC_VALUE_TACHOMETER         (1UL << 13)
+#define VESC_VALUE_TACHOMETER_ABS     (1UL << 14)
+#define VESC_VALUE_FAULT              (1UL << 15)
+#define VESC_VALUE_PID_POS            (1UL << 16)
+#define VESC_VALUE_CONTROLLER_ID      (1UL << 17)
+#define VESC_VALUE_COUNT 18
+#define VESC_VALUES_ALL ((1UL << VESC_VALUE_COUNT) - 1)
+
+//BYTES OF EACH FIELD ON THE WIRE, by mask bit
+const uint8_t vescValueSizes[VESC_VALUE_COUNT] = {2, 2, 4, 4, 4, 4, 2, 4, 2, 4, 4, 4, 4, 4, 4, 1, 4, 1};
+
+//SAME FIELDS AND UNITS AS VescUart's dataPackage
+struct vescData_t {
+  float avgMotorCurrent;
+  float avgInputCurrent;
+  float dutyCycleNow;
+  float rpm;
+  float inpVoltage;
+  float ampHours;
+  float ampHoursCharged;
+  float wattHours;
+  float wattHoursCharged;
+  long tachometer;
+  long tachometerAbs;
+  float tempMosfet;
+  float tempMotor;
+  float pidPos;
+  uint8_t id;
+  uint8_t error;
+};
+
+//CRC-16/XMODEM (poly 0x1021, init 0) used by the VESC packet layer
+static inline uint16_t vescCrc16(const uint8_t *data, uint16_t len, uint16_t crc = 0) {
+  for (uint16_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+class VescPoller {
+public:
+  vescData_t data = {};
+
+  //STATS
+  uint32_t requests = 0;
+  uint32_t replies = 0;
+  uint32_t timeouts = 0;
+  uint32_t badPackets = 0;
+
+  //valuesMask picks the fields to ask for, anything but VESC_VALUES_ALL uses the selective command for a shorter reply
+  void begin(Stream &serial, uint32_t pollIntervalMs = 10, uint32_t timeoutMs = 50, uint32_t valuesMask = VESC_VALUES_ALL) {
+    port = &serial;
+    pollInterval = pollIntervalMs;
+    timeout = timeoutMs;
+    mask = valuesMask & VESC_VALUES_ALL;
+    selective = mask != VESC_VALUES_ALL;
+    misses = 0;
+    state = STATE_IDLE;
+  }
+
+  //False once the VESC didn't answer the selective command and full values are polled instead
+  bool isSelective() const {
+    return selective;
+  }
+
+  //Call every loop, returns true when a new reply was decoded into data
+  bool update() {
+    uint32_t now = millis();
+
+    if (state == STATE_IDLE) {
+      if (now - requestMillis >= pollInterval) {
+        sendRequest(now);
+      }
+      return false;
+    }
+
+    while (state != STATE_IDLE && port->available() > 0) {
+      if (parseByte(port->read())) {
+        state = STATE_IDLE;
+        return true;
+      }
+    }
+
+    if (state != STATE_IDLE && now - requestMillis >= timeout) {
+      //NO (COMPLETE) REPLY, ask again
+      timeouts++;
+      state = STATE_IDLE;
+      if (selective && ++misses >= VESC_SELECTIVE_MAX_MISSES) {
+        selective = false;
+      }
+    }
+    return false;
+  }
+
+private:
+  enum {
+    STATE_IDLE,
+    STATE_START,
+    STATE_LENGTH_HI,
+    STATE_LENGTH_LO,
+    STATE_PAYLOAD,
+    STATE_CRC_HI,
+    STATE_CRC_LO,
+    STATE_END,
+  } state = STATE_IDLE;
+
+  Stream *port = nullptr;
+  uint32_t pollInterval = 10;
+  uint32_t timeout = 50;
+  uint32_t requestMillis = 0;
+  uint32_t mask = VESC_VALUES_ALL;
+  bool selective = false;
+  uint8_t misses = 0; // timeouts in a row
+
+  uint8_t payload[VESC_PACKET_MAX_PAYLOAD];
+  uint16_t payloadLength = 0;
+  uint16_t payloadPos = 0;
+  uint16_t packetCrc = 0;
+
+  void sendRequest(uint32_t now) {
+    //DROP ANYTHING LEFT OVER FROM A REPLY THAT TIMED OUT
+    while (port->available() > 0) {
+      port->read();
+    }
+
+    uint8_t packet[10];
+    uint8_t len = 0;
+    packet[len++] = 0x02;
+    if (selective) {
+      packet[len++] = 5;
+      packet[len++] = VESC_COMM_GET_VALUES_SELECTIVE;
+      packet[len++] = (uint8_t)(mask >> 24);
+      packet[len++] = (uint8_t)(mask >> 16);
+      packet[len++] = (uint8_t)(mask >> 8);
+      packet[len++] = (uint8_t)mask;
+    }
+    else {
+      packet[len++] = 1;
+      packet[len++] = VESC_COMM_GET_VALUES;
+    }
+    uint16_t crc = vescCrc16(&packet[2], packet[1]);
+    packet[len++] = (uint8_t)(crc >> 8);
+    packet[len++] = (uint8_t)crc;
+    packet[len++] = 0x03;
+    port->write(packet, len);
+
+    requests++;
+    requestMillis = now;
+    state = STATE_START;
+  }
+
+  //BROKEN REPLY (end byte or CRC), it's all in, don't wait for the timeout or the poll interval, ask again on the next update()
+  void badPacket() {
+    badPackets++;
+    state = STATE_IDLE;
+    requestMillis = millis() - pollInterval;
+  }
+
+  //Returns true when a complete, valid reply has been decoded
+  bool parseByte(uint8_t b) {
+    switch (state) {
+      case STATE_START:
+        if (b == 0x02) {
+          state = STATE_LENGTH_LO;
+        }
+        else if (b == 0x03) {
+          state = STATE_LENGTH_HI;
+        }
+        payloadLength = 0;
+        break;
+      case STATE_LENGTH_HI:
+        payloadLength = (uint16_t)b << 8;
+        state = STATE_LENGTH_LO;
+        break;
+      case STATE_LENGTH_LO:
+        payloadLength |= b;
+        payloadPos = 0;
+        if (payloadLength == 0 || payloadLength > VESC_PACKET_MAX_PAYLOAD) {
+          //REST OF THIS REPLY IS STILL COMING, a new request would only be answered behind it, look for the next start
+          badPackets++;
+          state = STATE_START;
+        }
+        else {
+          state = STATE_PAYLOAD;
+        }
+        break;
+      case STATE_PAYLOAD:
+        payload[payloadPos++] = b;
+        if (payloadPos == payloadLength) {
+          state = STATE_CRC_HI;
+        }
+        break;
+      case STATE_CRC_HI:
+        packetCrc = (uint16_t)b << 8;
+        state = STATE_CRC_LO;
+        break;
+      case STATE_CRC_LO:
+        packetCrc |= b;
+        state = STATE_END;
+        break;
+      case STATE_END:
+        if (b != 0x03 || packetCrc != vescCrc16(payload, payloadLength)) {
+          badPacket();
+          break;
+        }
+        state = STATE_START;
+        if (decodePayload()) {
+          replies++;
+          misses = 0;
+          return true;
+        }
+        break;
+      default:
+        break;
+    }
+    return false;
+  }
+
+  //BIG ENDIAN FIELD READERS, index moves past the field
+  int16_t get16(uint16_t &index) {
+    int16_t v = (int16_t)(((uint16_t)payload[index] << 8) | payload[index + 1]);
+    index += 2;
+    return v;
+  }
+
+  int32_t get32(uint16_t &index) {
+    int32_t v = (int32_t)(((uint32_t)payload[index] << 24) | ((uint32_t)payload[index + 1] << 16) |
+                          ((uint32_t)payload[index + 2] << 8) | payload[index + 3]);
+    index += 4;
+    return v;
+  }
+
+  bool decodePayload() {
+    //FULL REPLY HAS EVERY FIELD, THE SELECTIVE ONE ECHOES ITS MASK FIRST, newer firmwares append more fields after these
+    uint16_t i = 1;
+    uint32_t fields;
+    if (payload[0] == VESC_COMM_GET_VALUES) {
+      fields = VESC_VALUES_ALL;
+    }
+    else if (payload[0] == VESC_COMM_GET_VALUES_SELECTIVE && payloadLength >= 5) {
+      fields = (uint32_t)get32(i);
+    }
+    else {
+      return false;
+    }
+
+    uint16_t needed = i;
+    for (uint8_t bit = 0; bit < VESC_VALUE_COUNT; bit++) {
+      if (fields & (1UL << bit)) {
+        needed += vescValueSizes[bit];
+      }
+    }
+    if (payloadLength < needed) {
+      return false;
+    }
+
+    for (uint8_t bit = 0; bit < VESC_VALUE_COUNT; bit++) {
+      if (fields & (1UL << bit)) {
+        decodeValue(bit, i);
+      }
+    }
+    return true;
+  }
+
+  void decodeValue(uint8_t bit, uint16_t &i) {
+    switch (bit) {
+      case 0: data.tempMosfet = get16(i) / 10.0f; break;
+      case 1: data.tempMotor = get16(i) / 10.0f; break;
+      case 2: data.avgMotorCurrent = get32(i) / 100.0f; break;
+      case 3: data.avgInputCurrent = get32(i) / 100.0f; break;
+      case 6: data.dutyCycleNow = get16(i) / 1000.0f; break;
+      case 7: data.rpm = get32(i); break;
+      case 8: data.inpVoltage = get16(i) / 10.0f; break;
+      case 9: data.ampHours = get32(i) / 10000.0f; break;
+      case 10: data.ampHoursCharged = get32(i) / 10000.0f; break;
+      case 11: data.wattHours = get32(i) / 10000.0f; break;
+      case 12: data.wattHoursCharged = get32(i) / 10000.0f; break;
+      case 13: data.tachometer = get32(i); break;
+      case 14: data.tachometerAbs = get32(i); break;
+      case 15: data.error = payload[i++]; break;
+      case 16: data.pidPos = get32(i) / 1000000.0f; break;
+      case 17: data.id = payload[i++]; break;
+      default: i += vescValueSizes[bit]; break; // id, iq: not kept
+    }
+  }
+};
+
+#endif
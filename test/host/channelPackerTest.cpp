@@ -0,0 +1,121 @@
+//CHANNEL PACKING, BIT EXACT AGAINST THE OLD PACKER
+//The hand written 16 x 11 bit packing crsfPrepareDataPacket() used before ChannelPacker, with a bitwise CRC,
+//is the reference. Random channel changes (a few per frame, like sticks) go through the incremental packer and the
+//cached CRC prefix, every frame has to come out byte for byte the same.
+//Prints ns per frame for the old packer and the incremental one.
+
+#include "crsf.h"
+#include "hostTest.h"
+#include <chrono>
+#include <random>
+#include <vector>
+
+static uint8_t referenceCrc8(const uint8_t *data, uint8_t len)
+{
+    uint8_t crc = 0;
+    while (len--)
+    {
+        crc ^= *data++;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0xD5) : (uint8_t)(crc << 1);
+    }
+    return crc;
+}
+
+// crsfPrepareDataPacket() before the incremental packer, unchanged
+static void oldPrepareDataPacket(uint8_t packet[], int16_t channels[])
+{
+    packet[0] = ELRS_ADDRESS; // Header
+    packet[1] = 24;           // length of type (24) + payload + crc
+    packet[2] = TYPE_CHANNELS;
+    packet[3] = (uint8_t)(channels[0] & 0x07FF);
+    packet[4] = (uint8_t)((channels[0] & 0x07FF) >> 8 | (channels[1] & 0x07FF) << 3);
+    packet[5] = (uint8_t)((channels[1] & 0x07FF) >> 5 | (channels[2] & 0x07FF) << 6);
+    packet[6] = (uint8_t)((channels[2] & 0x07FF) >> 2);
+    packet[7] = (uint8_t)((channels[2] & 0x07FF) >> 10 | (channels[3] & 0x07FF) << 1);
+    packet[8] = (uint8_t)((channels[3] & 0x07FF) >> 7 | (channels[4] & 0x07FF) << 4);
+    packet[9] = (uint8_t)((channels[4] & 0x07FF) >> 4 | (channels[5] & 0x07FF) << 7);
+    packet[10] = (uint8_t)((channels[5] & 0x07FF) >> 1);
+    packet[11] = (uint8_t)((channels[5] & 0x07FF) >> 9 | (channels[6] & 0x07FF) << 2);
+    packet[12] = (uint8_t)((channels[6] & 0x07FF) >> 6 | (channels[7] & 0x07FF) << 5);
+    packet[13] = (uint8_t)((channels[7] & 0x07FF) >> 3);
+    packet[14] = (uint8_t)((channels[8] & 0x07FF));
+    packet[15] = (uint8_t)((channels[8] & 0x07FF) >> 8 | (channels[9] & 0x07FF) << 3);
+    packet[16] = (uint8_t)((channels[9] & 0x07FF) >> 5 | (channels[10] & 0x07FF) << 6);
+    packet[17] = (uint8_t)((channels[10] & 0x07FF) >> 2);
+    packet[18] = (uint8_t)((channels[10] & 0x07FF) >> 10 | (channels[11] & 0x07FF) << 1);
+    packet[19] = (uint8_t)((channels[11] & 0x07FF) >> 7 | (channels[12] & 0x07FF) << 4);
+    packet[20] = (uint8_t)((channels[12] & 0x07FF) >> 4 | (channels[13] & 0x07FF) << 7);
+    packet[21] = (uint8_t)((channels[13] & 0x07FF) >> 1);
+    packet[22] = (uint8_t)((channels[13] & 0x07FF) >> 9 | (channels[14] & 0x07FF) << 2);
+    packet[23] = (uint8_t)((channels[14] & 0x07FF) >> 6 | (channels[15] & 0x07FF) << 5);
+    packet[24] = (uint8_t)((channels[15] & 0x07FF) >> 3);
+
+    packet[25] = referenceCrc8(&packet[2], packet[1] - 1); // CRC
+}
+
+const int frames = 200000;
+
+int main()
+{
+    std::mt19937 rng(7);
+    CRSF crsf;
+    int16_t channels[CRSF_MAX_CHANNEL];
+    for (auto &c : channels)
+        c = 992;
+
+    // Changes per frame: mostly one or two channels, sometimes none or all, now and then out of the 11 bit range
+    std::vector<std::vector<int16_t>> sequence;
+    for (int i = 0; i < frames; i++)
+    {
+        int changes = rng() % 100 < 5 ? CRSF_MAX_CHANNEL : rng() % 3;
+        for (int k = 0; k < changes; k++)
+        {
+            int16_t v = rng() % 2048;
+            if (rng() % 50 == 0)
+                v = (int16_t)(rng() % 8192) - 4096;
+            channels[rng() % CRSF_MAX_CHANNEL] = v;
+        }
+        sequence.emplace_back(channels, channels + CRSF_MAX_CHANNEL);
+    }
+
+    int mismatches = 0;
+    for (auto &ch : sequence)
+    {
+        uint8_t newFrame[CRSF_PACKET_SIZE], oldFrame[CRSF_PACKET_SIZE];
+        crsf.crsfPrepareDataPacket(newFrame, ch.data());
+        oldPrepareDataPacket(oldFrame, ch.data());
+        if (memcmp(newFrame, oldFrame, CRSF_PACKET_SIZE) != 0)
+            mismatches++;
+    }
+    CHECK_EQ(mismatches, 0);
+
+    // FULL PACK ON ITS OWN matches too, and update() reports the first byte it touched
+    ChannelPacker<CRSF_MAX_CHANNEL, 11> packer;
+    uint8_t incremental[ChannelPacker<CRSF_MAX_CHANNEL, 11>::packedSize];
+    for (auto &ch : sequence)
+    {
+        uint8_t before[sizeof(incremental)], full[sizeof(incremental)];
+        memcpy(before, incremental, sizeof(before));
+        uint8_t first = packer.update(incremental, ch.data());
+        ChannelPacker<CRSF_MAX_CHANNEL, 11>::pack(full, ch.data());
+        if (memcmp(incremental, full, sizeof(full)) != 0 || (first > 0 && memcmp(before, incremental, first) != 0))
+            mismatches++;
+    }
+    CHECK_EQ(mismatches, 0);
+
+    // TIMING, same sequence through both
+    uint8_t frame[CRSF_PACKET_SIZE];
+    auto start = std::chrono::steady_clock::now();
+    for (auto &ch : sequence)
+        oldPrepareDataPacket(frame, ch.data());
+    double oldNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+    CRSF timed;
+    start = std::chrono::steady_clock::now();
+    for (auto &ch : sequence)
+        timed.crsfPrepareDataPacket(frame, ch.data());
+    double newNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+    printf("frames,old ns/frame,incremental ns/frame\n%d,%.1f,%.1f\n", frames, oldNs, newNs);
+
+    return hostTestResult("channelPackerTest");
+}
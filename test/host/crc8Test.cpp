@@ -0,0 +1,98 @@
+//CRC-8/DVB-S2, GENERATED TABLES AND SLICING
+//Checks the compile time tables against the table from the CRSF protocol document rev7 (the one crsf.cpp used to
+//carry) and crsf_crc8() against the old byte loop for every length a frame can have, at both CRSF_CRC8_SLICES.
+//The Makefile builds it twice, crc8Test1 and crc8Test4. Prints ns per call for the frame lengths that matter.
+
+#include "crc8.h"
+#include "hostTest.h"
+#include <chrono>
+#include <random>
+#include <vector>
+
+// crc implementation from CRSF protocol document rev7, as it was in crsf.cpp
+// crc implementation from CRSF protocol document rev7
+static uint8_t crsf_crc8tab[256] = {
+    0x00, 0xD5, 0x7F, 0xAA, 0xFE, 0x2B, 0x81, 0x54, 0x29, 0xFC, 0x56, 0x83, 0xD7, 0x02, 0xA8, 0x7D,
+    0x52, 0x87, 0x2D, 0xF8, 0xAC, 0x79, 0xD3, 0x06, 0x7B, 0xAE, 0x04, 0xD1, 0x85, 0x50, 0xFA, 0x2F,
+    0xA4, 0x71, 0xDB, 0x0E, 0x5A, 0x8F, 0x25, 0xF0, 0x8D, 0x58, 0xF2, 0x27, 0x73, 0xA6, 0x0C, 0xD9,
+    0xF6, 0x23, 0x89, 0x5C, 0x08, 0xDD, 0x77, 0xA2, 0xDF, 0x0A, 0xA0, 0x75, 0x21, 0xF4, 0x5E, 0x8B,
+    0x9D, 0x48, 0xE2, 0x37, 0x63, 0xB6, 0x1C, 0xC9, 0xB4, 0x61, 0xCB, 0x1E, 0x4A, 0x9F, 0x35, 0xE0,
+    0xCF, 0x1A, 0xB0, 0x65, 0x31, 0xE4, 0x4E, 0x9B, 0xE6, 0x33, 0x99, 0x4C, 0x18, 0xCD, 0x67, 0xB2,
+    0x39, 0xEC, 0x46, 0x93, 0xC7, 0x12, 0xB8, 0x6D, 0x10, 0xC5, 0x6F, 0xBA, 0xEE, 0x3B, 0x91, 0x44,
+    0x6B, 0xBE, 0x14, 0xC1, 0x95, 0x40, 0xEA, 0x3F, 0x42, 0x97, 0x3D, 0xE8, 0xBC, 0x69, 0xC3, 0x16,
+    0xEF, 0x3A, 0x90, 0x45, 0x11, 0xC4, 0x6E, 0xBB, 0xC6, 0x13, 0xB9, 0x6C, 0x38, 0xED, 0x47, 0x92,
+    0xBD, 0x68, 0xC2, 0x17, 0x43, 0x96, 0x3C, 0xE9, 0x94, 0x41, 0xEB, 0x3E, 0x6A, 0xBF, 0x15, 0xC0,
+    0x4B, 0x9E, 0x34, 0xE1, 0xB5, 0x60, 0xCA, 0x1F, 0x62, 0xB7, 0x1D, 0xC8, 0x9C, 0x49, 0xE3, 0x36,
+    0x19, 0xCC, 0x66, 0xB3, 0xE7, 0x32, 0x98, 0x4D, 0x30, 0xE5, 0x4F, 0x9A, 0xCE, 0x1B, 0xB1, 0x64,
+    0x72, 0xA7, 0x0D, 0xD8, 0x8C, 0x59, 0xF3, 0x26, 0x5B, 0x8E, 0x24, 0xF1, 0xA5, 0x70, 0xDA, 0x0F,
+    0x20, 0xF5, 0x5F, 0x8A, 0xDE, 0x0B, 0xA1, 0x74, 0x09, 0xDC, 0x76, 0xA3, 0xF7, 0x22, 0x88, 0x5D,
+    0xD6, 0x03, 0xA9, 0x7C, 0x28, 0xFD, 0x57, 0x82, 0xFF, 0x2A, 0x80, 0x55, 0x01, 0xD4, 0x7E, 0xAB,
+    0x84, 0x51, 0xFB, 0x2E, 0x7A, 0xAF, 0x05, 0xD0, 0xAD, 0x78, 0xD2, 0x07, 0x53, 0x86, 0x2C, 0xF9};
+
+const int maxFrameLen = 64; // CRSF_MAX_PACKET_LEN
+
+static uint8_t oldCrc8(const uint8_t *ptr, uint8_t len) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < len; i++){
+        crc = crsf_crc8tab[crc ^ *ptr++];
+    }
+    return crc;
+}
+
+static uint8_t bytewiseCrc8(const uint8_t *ptr, uint8_t len)
+{
+    uint8_t crc = 0;
+    while (len--)
+        crc = crsf_crc8_byte(crc, *ptr++);
+    return crc;
+}
+
+static double NsPerCall(uint8_t (*crc)(const uint8_t *, uint8_t), const std::vector<uint8_t> &data, uint8_t len)
+{
+    const int calls = 2000000;
+    volatile uint8_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++)
+        sink = sink ^ crc(&data[i & 63], len);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+int main()
+{
+    // TABLES, every slice against the reference table run k more times
+    for (int i = 0; i < 256; i++)
+    {
+        CHECK_EQ(crsfCrc8Tables.t[0][i], crsf_crc8tab[i]);
+        uint8_t expected = crsf_crc8tab[i];
+        for (int k = 1; k < CRSF_CRC8_SLICES; k++)
+        {
+            expected = crsf_crc8tab[expected];
+            CHECK_EQ(crsfCrc8Tables.t[k][i], expected);
+        }
+    }
+
+    // EQUIVALENCE, all lengths up to the biggest CRSF frame, every start alignment
+    std::mt19937 rng(8);
+    std::vector<uint8_t> data(maxFrameLen + 64);
+    for (auto &b : data)
+        b = rng();
+    for (int round = 0; round < 200; round++)
+    {
+        for (int len = 0; len <= maxFrameLen; len++)
+            for (int align = 0; align < 4; align++)
+            {
+                CHECK_EQ(crsf_crc8(&data[align], len), oldCrc8(&data[align], len));
+                CHECK_EQ(bytewiseCrc8(&data[align], len), oldCrc8(&data[align], len));
+            }
+        for (auto &b : data)
+            b = rng();
+    }
+
+    // BENCHMARK, command packet (6), channel payload (24), biggest frame
+    printf("slices,len,old ns,crsf_crc8 ns,crsf_crc8_byte ns\n");
+    for (uint8_t len : {6, 24, maxFrameLen - 2})
+        printf("%d,%d,%.1f,%.1f,%.1f\n", CRSF_CRC8_SLICES, len, NsPerCall(oldCrc8, data, len),
+               NsPerCall(crsf_crc8, data, len), NsPerCall(bytewiseCrc8, data, len));
+
+    return hostTestResult(CRSF_CRC8_SLICES == 4 ? "crc8Test4" : "crc8Test1");
+}
@@ -0,0 +1,132 @@
+#ifndef CRSFBASELINEPARSER_H
+#define CRSFBASELINEPARSER_H
+
+#include "crsf.h"
+
+//CRSF RECEIVE PATH BEFORE THE RING BUFFER, the reference for crsfRxBench
+//handleSerialIn(), handleByteReceived(), checkPacketTimeout() and shiftRxBuffer() as crsf.cpp had them: a linear buffer
+//that is shifted down byte by byte on every resync, at most 5 bytes read per call. processPacketIn() only keeps what
+//the bench checks (battery voltage, downlink LQ) and counts frames.
+class BaselineCrsfParser
+{
+public:
+    uint32_t frames = 0;
+    uint16_t voltage = 0;
+    uint8_t downlinkLinkQuality = 0;
+
+    void begin(Stream &serial) { CRSFSerial = &serial; }
+
+    void handleSerialIn()
+    {
+        int maxPackets = 5;
+        while (CRSFSerial->available() && maxPackets > 0)
+        {
+            uint8_t b = CRSFSerial->read();
+            _lastReceive = millis();
+
+            _rxBuf[_rxBufPos++] = b;
+            handleByteReceived();
+
+            if (_rxBufPos == (sizeof(_rxBuf)/sizeof(_rxBuf[0])))
+            {
+                // Packet buffer filled and no valid packet found, dump the whole thing
+                _rxBufPos = 0;
+            }
+            --maxPackets;
+        }
+
+        checkPacketTimeout();
+    }
+
+private:
+    Stream *CRSFSerial = nullptr;
+    uint8_t _rxBuf[CRSF_MAX_PACKET_LEN+3];
+    uint8_t _rxBufPos = 0;
+    uint32_t _lastReceive = 0;
+
+    void handleByteReceived()
+    {
+        bool reprocess;
+        int maxPackets = 5;
+        do
+        {
+            reprocess = false;
+            if (_rxBufPos > 1)
+            {
+                uint8_t len = _rxBuf[1];
+                // Sanity check the declared length, can't be shorter than Type, X, CRC
+                if (len < 3 || len > CRSF_MAX_PACKET_LEN)
+                {
+                    shiftRxBuffer(1);
+                    reprocess = true;
+                }
+
+                else if (_rxBufPos >= (len + 2))
+                {
+                    uint8_t inCrc = _rxBuf[2 + len - 1];
+                    uint8_t crc = crsf_crc8(&_rxBuf[2], len - 1);
+
+                    if (crc == inCrc)
+                    {
+                        processPacketIn(len);
+                        shiftRxBuffer(len + 2);
+                        reprocess = true;
+                    }
+                    else
+                    {
+                        shiftRxBuffer(1);
+                        reprocess = true;
+                    }
+                }  // if complete packet
+            } // if pos > 1
+
+            if(maxPackets <= 0) {
+              reprocess = false;
+            }
+            --maxPackets;
+
+        } while (reprocess);
+    }
+
+    void checkPacketTimeout()
+    {
+        // If we haven't received data in a long time, flush the buffer a byte at a time (to trigger shiftyByte)
+        if (_rxBufPos > 0 && millis() - _lastReceive > CRSF_PACKET_TIMEOUT_MS)
+            while (_rxBufPos)
+                shiftRxBuffer(1);
+    }
+
+    void processPacketIn(uint8_t len)
+    {
+        (void)len;
+        const crsf_header_t *hdr = (crsf_header_t *)_rxBuf;
+        if (hdr->device_addr != CRSF_ADDRESS_RADIO_TRANSMITTER)
+            return;
+        frames++;
+        if (hdr->type == CRSF_FRAMETYPE_BATTERY_SENSOR)
+            voltage = (hdr->data[0] << 8) | hdr->data[1];
+        else if (hdr->type == CRSF_FRAMETYPE_LINK_STATISTICS)
+            downlinkLinkQuality = hdr->data[8];
+    }
+
+    // Shift the bytes in the RxBuf down by cnt bytes
+    void shiftRxBuffer(uint8_t cnt)
+    {
+        // If removing the whole thing, just set pos to 0
+        if (cnt >= _rxBufPos)
+        {
+            _rxBufPos = 0;
+            return;
+        }
+
+        // Otherwise do the slow shift down
+        uint8_t *src = &_rxBuf[cnt];
+        uint8_t *dst = &_rxBuf[0];
+        _rxBufPos -= cnt;
+        uint8_t left = _rxBufPos;
+        while (left--)
+            *dst++ = *src++;
+    }
+};
+
+#endif
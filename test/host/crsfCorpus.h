@@ -0,0 +1,91 @@
+#ifndef CRSFCORPUS_H
+#define CRSFCORPUS_H
+
+#include <vector>
+#include <random>
+#include "crsf.h"
+
+//CRSF RECEIVE CORPUS
+//Telemetry the way a TX module sends it to the handset, generated from a fixed seed so every run parses the same bytes:
+//  valid   - back to back frames of every decoded type
+//  garbage - the same frames with noise in between, including bytes that look like a frame start with a plausible length
+//  split   - the valid stream, handed to the parser a few bytes per call (see the benchmark)
+
+struct CrsfCorpus
+{
+    std::vector<uint8_t> bytes;
+    uint32_t frames = 0;         // valid frames in it
+    uint16_t lastVoltage = 0;    // battery voltage of the last battery frame, checks the decode end to end
+    uint8_t lastLinkQuality = 0; // downlink LQ of the last link statistics frame
+};
+
+static inline void crsfCorpusFrame(CrsfCorpus &corpus, uint8_t type, const uint8_t *payload, uint8_t len)
+{
+    uint8_t frame[CRSF_FRAME_SIZE_MAX + 4];
+    frame[0] = CRSF_ADDRESS_RADIO_TRANSMITTER;
+    frame[1] = len + 2;
+    frame[2] = type;
+    memcpy(&frame[3], payload, len);
+    frame[len + 3] = crsf_crc8(&frame[2], len + 1);
+    corpus.bytes.insert(corpus.bytes.end(), frame, frame + len + 4);
+    corpus.frames++;
+}
+
+// One of each telemetry frame the remote decodes, with values from the generator
+static inline void crsfCorpusRound(CrsfCorpus &corpus, std::mt19937 &rng)
+{
+    uint8_t p[16];
+    for (auto &b : p)
+        b = rng();
+
+    uint8_t battery[8] = {p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]};
+    corpus.lastVoltage = (battery[0] << 8) | battery[1];
+    crsfCorpusFrame(corpus, CRSF_FRAMETYPE_BATTERY_SENSOR, battery, sizeof(battery));
+
+    uint8_t link[10] = {p[8], p[9], 100, 5, 0, 4, 2, p[10], (uint8_t)(p[11] % 101), 3};
+    corpus.lastLinkQuality = link[8];
+    crsfCorpusFrame(corpus, CRSF_FRAMETYPE_LINK_STATISTICS, link, sizeof(link));
+
+    crsfCorpusFrame(corpus, CRSF_FRAMETYPE_GPS, p, sizeof(crsf_sensor_gps_t));
+    crsfCorpusFrame(corpus, CRSF_FRAMETYPE_ATTITUDE, p, sizeof(crsf_sensor_attitude_t));
+    crsfCorpusFrame(corpus, CRSF_FRAMETYPE_BARO_ALTITUDE, p, sizeof(crsf_sensor_baro_altitude_t));
+
+    uint8_t sync[2 + sizeof(crsf_radio_id_sync_t)] = {CRSF_ADDRESS_RADIO_TRANSMITTER, CRSF_ADDRESS_CRSF_TRANSMITTER, CRSF_RADIO_ID_TIMING_SYNC,
+                                                      0, 0, 0x9C, 0x40, 0, 0, 0, (uint8_t)(p[12] & 0x7F)};
+    crsfCorpusFrame(corpus, CRSF_FRAMETYPE_RADIO_ID, sync, sizeof(sync));
+}
+
+static inline CrsfCorpus crsfCorpusValid(int rounds)
+{
+    CrsfCorpus corpus;
+    std::mt19937 rng(1);
+    for (int i = 0; i < rounds; i++)
+        crsfCorpusRound(corpus, rng);
+    return corpus;
+}
+
+static inline CrsfCorpus crsfCorpusGarbage(int rounds)
+{
+    CrsfCorpus corpus;
+    std::mt19937 rng(2);
+    for (int i = 0; i < rounds; i++)
+    {
+        int noise = rng() % 24;
+        for (int k = 0; k < noise; k++)
+        {
+            uint8_t b = rng();
+            // A third of the noise starts like a frame: known address, then a length the parser has to wait for
+            if (k + 1 < noise && rng() % 3 == 0)
+            {
+                corpus.bytes.push_back(CRSF_ADDRESS_RADIO_TRANSMITTER);
+                b = 3 + rng() % (CRSF_MAX_PACKET_LEN - 2);
+                k++;
+            }
+            corpus.bytes.push_back(b);
+        }
+        crsfCorpusRound(corpus, rng);
+    }
+    return corpus;
+}
+
+#endif
@@ -0,0 +1,142 @@
+//CRSF RECEIVE PATH ON THE HOST
+//Feeds the corpus through CRSF::handleSerialIn() and through the old linear buffer parser (crsfBaselineParser.h), checks
+//every valid frame comes out of both, then prints the cost side by side:
+//CSV: corpus, bytes, frames expected, old frames parsed, new frames parsed, crc errors, skipped bytes,
+//     old ns/byte, new ns/byte, old worst ns per handleSerialIn() call, new worst ns per call
+//Needs CRSF_PROFILE for the parser counters (the Makefile sets it).
+
+#include "crsf.h"
+#include "crsfBaselineParser.h"
+#include "crsfCorpus.h"
+#include "fakeSerial.h"
+#include "hostTest.h"
+#include <chrono>
+
+const int corpusRounds = 2000;
+const int benchRepeats = 20;
+
+struct BenchResult
+{
+    double nsPerByte = 1e9;  // best of the repeats
+    double maxCallNs = 1e9;  // the slowest call of a run, best of the repeats so one preemption doesn't decide it
+};
+
+// Split delivery hands the parser 1 to 8 bytes per call, the way a busy loop sees a 420k UART. Both parsers get the
+// same chunks, then handleSerialIn() runs until the UART is drained (the old parser takes at most 5 bytes per call).
+// timeCalls adds a clock read around every call, so the max call pass is kept apart from the ns/byte pass.
+template <typename Parser>
+static double runParser(Parser &parser, FakeSerial &serial, const CrsfCorpus &corpus, bool split, bool timeCalls)
+{
+    std::mt19937 rng(3);
+    double maxCallNs = 0;
+    auto call = [&]() {
+        if (!timeCalls)
+        {
+            parser.handleSerialIn();
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        parser.handleSerialIn();
+        maxCallNs = max(maxCallNs, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+    };
+
+    if (split)
+    {
+        size_t pos = 0;
+        while (pos < corpus.bytes.size())
+        {
+            size_t chunk = min((size_t)(1 + rng() % 8), corpus.bytes.size() - pos);
+            serial.Deliver(&corpus.bytes[pos], chunk);
+            pos += chunk;
+            call();
+        }
+    }
+    else
+    {
+        serial.Deliver(corpus.bytes);
+    }
+    while (serial.available())
+        call();
+    return maxCallNs;
+}
+
+template <typename Parser, typename Check>
+static BenchResult benchParser(const CrsfCorpus &corpus, bool split, Check check)
+{
+    BenchResult result;
+    for (int repeat = 0; repeat < benchRepeats; repeat++)
+    {
+        FakeSerial serial;
+        Parser parser;
+        parser.begin(serial);
+
+        auto start = std::chrono::steady_clock::now();
+        runParser(parser, serial, corpus, split, false);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        result.nsPerByte = min(result.nsPerByte, ns / corpus.bytes.size());
+
+        if (repeat == 0)
+            check(parser);
+    }
+    for (int repeat = 0; repeat < benchRepeats; repeat++)
+    {
+        FakeSerial serial;
+        Parser parser;
+        parser.begin(serial);
+        result.maxCallNs = min(result.maxCallNs, runParser(parser, serial, corpus, split, true));
+    }
+    return result;
+}
+
+static void runCorpus(const char *name, const CrsfCorpus &corpus, bool split, bool garbage)
+{
+    uint32_t oldFrames = 0;
+    BenchResult oldResult = benchParser<BaselineCrsfParser>(corpus, split, [&](BaselineCrsfParser &parser) {
+        oldFrames = parser.frames;
+        CHECK_EQ(parser.voltage, corpus.lastVoltage);
+        CHECK_EQ(parser.downlinkLinkQuality, corpus.lastLinkQuality);
+        if (garbage)
+            CHECK(parser.frames >= corpus.frames * 99 / 100);
+        else
+            CHECK_EQ(parser.frames, corpus.frames);
+    });
+
+    crsfProfile_t profile;
+    BenchResult newResult = benchParser<CRSF>(corpus, split, [&](CRSF &crsf) {
+        profile = crsf._profile;
+
+        crsfTelemetry_t telemetry;
+        crsf._telemetry.snapshot(telemetry);
+        CHECK_EQ(telemetry.battery.voltage, corpus.lastVoltage);
+        CHECK_EQ(telemetry.link.downlink_Link_quality, corpus.lastLinkQuality);
+        CHECK_EQ(crsf._rxStats.droppedBytes, 0);
+        if (garbage)
+        {
+            // An 8 bit CRC passes about 1 in 256 false starts, and a false frame swallows the real ones it overlaps,
+            // so a few frames get lost in this much noise. Anything beyond that is the parser losing sync.
+            CHECK(profile.rxFrames >= corpus.frames * 99 / 100);
+        }
+        else
+        {
+            CHECK_EQ(profile.rxFrames, corpus.frames);
+            CHECK_EQ(profile.rxCrcErrors, 0);
+            CHECK_EQ(profile.rxSkippedBytes, 0);
+        }
+    });
+
+    printf("%s,%zu,%u,%u,%u,%u,%u,%.1f,%.1f,%.0f,%.0f\n", name, corpus.bytes.size(), corpus.frames, oldFrames,
+           profile.rxFrames, profile.rxCrcErrors, profile.rxSkippedBytes, oldResult.nsPerByte, newResult.nsPerByte,
+           oldResult.maxCallNs, newResult.maxCallNs);
+}
+
+int main()
+{
+    CrsfCorpus valid = crsfCorpusValid(corpusRounds);
+    CrsfCorpus garbage = crsfCorpusGarbage(corpusRounds);
+
+    printf("corpus,bytes,frames,old parsed,new parsed,crc errors,skipped,old ns/byte,new ns/byte,old max call ns,new max call ns\n");
+    runCorpus("valid", valid, false, false);
+    runCorpus("garbage", garbage, false, true);
+    runCorpus("split", valid, true, false);
+    return hostTestResult("crsfRxBench");
+}
@@ -0,0 +1,122 @@
+//CRSF TRANSMIT PATH AGAINST A BAUD TIMED UART
+//Queues channel frames through CrsfWritePacket()/pumpTx() on a fake UART and checks when each byte is handed over
+//and when it leaves the wire, for a UART that reports its free space, a core that doesn't (availableForWrite() = 0)
+//and a UART that stalls.
+//CSV: case, frames, us from queueing the last frame to its last byte on the wire, blocking writes
+
+#include "crsf.h"
+#include "fakeSerial.h"
+#include "hostTest.h"
+
+const uint32_t crsfBaud = 420000;
+const uint32_t frameIntervalUs = 4000;
+
+struct TxRun
+{
+    CRSF crsf;
+    FakeUart uart;
+    uint8_t frame[CRSF_PACKET_SIZE];
+
+    TxRun(int fifoSize) : uart(crsfBaud, fifoSize)
+    {
+        hostSetMicros(0);
+        crsf.begin(uart);
+        crsf.setFrameInterval(frameIntervalUs);
+        int16_t channels[CRSF_MAX_CHANNEL];
+        for (auto &c : channels)
+            c = 992;
+        crsf.crsfPrepareDataPacket(frame, channels);
+    }
+
+    // Call pumpTx() every stepUs like loop() does, until the queue is empty or timeoutUs passed
+    void Pump(uint32_t stepUs, uint32_t timeoutUs)
+    {
+        uint32_t end = micros() + timeoutUs;
+        while (!crsf.txIdle() && micros() < end)
+        {
+            hostAdvanceMicros(stepUs);
+            crsf.pumpTx();
+        }
+    }
+
+    void Report(const char *name, uint32_t frames, uint32_t lastQueuedUs)
+    {
+        printf("%s,%u,%.0f,%u\n", name, frames, uart.wireDone.back() - lastQueuedUs, crsf._txStats.blockingWrites);
+    }
+};
+
+int main()
+{
+    printf("case,frames,queue to wire us,blocking writes\n");
+    double frameWireUs = CRSF_PACKET_SIZE * 10e6 / crsfBaud;
+
+    {
+        // UART WITH ROOM FOR THE WHOLE FRAME: handed over at once, on the wire after its own transmit time
+        TxRun run(64);
+        run.crsf.CrsfWritePacket(run.frame, CRSF_PACKET_SIZE);
+        CHECK_EQ(run.uart.tx.size(), CRSF_PACKET_SIZE);
+        CHECK(run.crsf.txIdle());
+        CHECK(fabs(run.uart.wireDone.back() - frameWireUs) < 1);
+        CHECK_EQ(run.crsf._txStats.blockingWrites, 0);
+        run.Report("fifo64", 1, 0);
+    }
+
+    {
+        // SMALL FIFO: two frames go out in chunks as room frees up, back to back on the wire, never blocking
+        TxRun run(16);
+        run.crsf.CrsfWritePacket(run.frame, CRSF_PACKET_SIZE);
+        run.crsf.CrsfWritePacket(run.frame, CRSF_PACKET_SIZE);
+        CHECK_EQ(run.uart.tx.size(), 16);
+        run.Pump(20, frameIntervalUs);
+        CHECK(run.crsf.txIdle());
+        CHECK_EQ(run.uart.tx.size(), 2 * CRSF_PACKET_SIZE);
+        // Each refill waits for up to one 20us pump step, a byte time is 24us, so the line never idles for long
+        CHECK(run.uart.wireDone.back() < 2 * frameWireUs + 100);
+        CHECK_EQ(run.crsf._txStats.blockingWrites, 0);
+        CHECK_EQ(run.crsf._txStats.frames, 2);
+        run.Report("fifo16", 2, 0);
+    }
+
+    {
+        // CORE WITHOUT availableForWrite(): written right away like the old blocking write, not a frame interval later
+        TxRun run(64);
+        run.uart.reportsRoom = false;
+        uint32_t queued = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            queued = micros();
+            run.crsf.CrsfWritePacket(run.frame, CRSF_PACKET_SIZE);
+            CHECK_EQ(run.uart.tx.size(), (i + 1) * CRSF_PACKET_SIZE);
+            CHECK(run.crsf.txIdle());
+            CHECK(run.uart.wireDone.back() - queued < frameWireUs + 1);
+            hostAdvanceMicros(frameIntervalUs);
+        }
+        CHECK_EQ(run.crsf._txStats.blockingWrites, 3);
+        run.Report("noAvailableForWrite", 3, queued);
+    }
+
+    {
+        // STALLED UART: it reported room before, then stops sending. Once its FIFO is full the next frame waits
+        // a frame interval for room, then is forced out
+        TxRun run(32);
+        run.crsf.CrsfWritePacket(run.frame, CRSF_PACKET_SIZE);
+        hostAdvanceMicros(1000);
+        run.uart.stalled = true;
+        run.crsf.CrsfWritePacket(run.frame, CRSF_PACKET_SIZE);
+        CHECK(run.crsf.txIdle());
+        run.crsf.CrsfWritePacket(run.frame, CRSF_PACKET_SIZE);
+        size_t handed = run.uart.tx.size();
+        CHECK_EQ(handed, 2 * CRSF_PACKET_SIZE + (32 - CRSF_PACKET_SIZE));
+        run.Pump(100, frameIntervalUs - 200);
+        CHECK_EQ(run.uart.tx.size(), handed);
+        CHECK_EQ(run.crsf._txStats.blockingWrites, 0);
+        run.Pump(100, 400);
+        CHECK(run.crsf.txIdle());
+        CHECK_EQ(run.uart.tx.size(), 3 * CRSF_PACKET_SIZE);
+        CHECK_EQ(run.crsf._txStats.blockingWrites, 1);
+        // The stalled line never sends, report how long the frame waited before it was forced into the UART instead
+        printf("stalled,3,%u,%u\n", (unsigned)(micros() - 1000), run.crsf._txStats.blockingWrites);
+    }
+
+    return hostTestResult("crsfTxTest");
+}
@@ -0,0 +1,76 @@
+#ifndef FAKESERIAL_H
+#define FAKESERIAL_H
+
+#include <Arduino.h>
+#include <vector>
+
+//IN-MEMORY SERIAL PORT
+//Tests push what the other side sends into rx (all at once or a few bytes at a time with Deliver),
+//everything the code writes ends up in tx.
+class FakeSerial : public Stream
+{
+public:
+    std::vector<uint8_t> rx; // bytes the port has received but not handed out yet
+    size_t rxPos = 0;
+    std::vector<uint8_t> tx; // everything written
+
+    void Deliver(const uint8_t *data, size_t len) { rx.insert(rx.end(), data, data + len); }
+    void Deliver(const std::vector<uint8_t> &data) { Deliver(data.data(), data.size()); }
+
+    int available() override { return (int)(rx.size() - rxPos); }
+    int read() override { return rxPos < rx.size() ? rx[rxPos++] : -1; }
+    int peek() override { return rxPos < rx.size() ? rx[rxPos] : -1; }
+    size_t write(uint8_t b) override
+    {
+        tx.push_back(b);
+        return 1;
+    }
+    using Print::write;
+};
+
+//UART WITH A TX FIFO THAT EMPTIES AT THE BAUD RATE, timed by the host clock (hostSetMicros)
+//Every written byte gets the time its stop bit leaves the wire. A full FIFO makes write() block the way a
+//real one does, by moving the clock on. reportsRoom = false behaves like a core without availableForWrite(),
+//stalled = true stops the line (nothing leaves the FIFO).
+class FakeUart : public FakeSerial
+{
+public:
+    uint32_t baud;
+    int fifoSize;
+    bool reportsRoom = true;
+    bool stalled = false;
+    std::vector<double> wireDone; // per byte in tx, micros when it was fully sent
+
+    FakeUart(uint32_t _baud, int _fifoSize) : baud(_baud), fifoSize(_fifoSize) {}
+
+    double ByteMicros() const { return 10e6 / baud; } // start + 8 data + stop bits
+
+    // Bytes still in the FIFO or being shifted out
+    int InFlight()
+    {
+        double now = micros();
+        int n = 0;
+        for (size_t i = wireDone.size(); i-- > 0 && wireDone[i] > now;)
+            n++;
+        return n;
+    }
+
+    int availableForWrite() override
+    {
+        if (!reportsRoom)
+            return 0;
+        return fifoSize - InFlight();
+    }
+
+    size_t write(uint8_t b) override
+    {
+        while (!stalled && InFlight() >= fifoSize)
+            hostSetMicros((unsigned long)ceil(wireDone[wireDone.size() - fifoSize]));
+        double start = max((double)micros(), wireDone.empty() ? 0.0 : wireDone.back());
+        wireDone.push_back(stalled ? 1e18 : start + ByteMicros());
+        return FakeSerial::write(b);
+    }
+    using Print::write;
+};
+
+#endif
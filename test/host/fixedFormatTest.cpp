@@ -0,0 +1,106 @@
+//FIXED POINT SCREEN FORMATTING
+//Edge cases of formatFixed(): rounding half away from zero, negatives that round to zero, '#' on overflow, the
+//int32 limits. Then random values and formats against a reference built with 64 bit math and snprintf.
+
+#include "fixedFormat.h"
+#include "hostTest.h"
+#include <random>
+#include <string.h>
+
+static void Expect(int32_t value, FixedFormat spec, const char *expected, int line)
+{
+    char text[48];
+    uint8_t len = formatFixed(text, value, spec);
+    text[len] = 0;
+    if (strcmp(text, expected) != 0)
+    {
+        hostFailures++;
+        printf("%s:%d: formatFixed(%d, {%d,%d,%d}) = '%s', expected '%s'\n", __FILE__, line, value, spec.width,
+               spec.decimals, spec.inputDecimals, text, expected);
+    }
+}
+#define EXPECT_FORMAT(value, spec, expected) Expect(value, spec, expected, __LINE__)
+
+// Same result the long way: 64 bit rounding half away from zero, then printf
+static void Reference(char *text, int32_t value, FixedFormat spec)
+{
+    long long magnitude = value < 0 ? -(long long)value : value;
+    if (spec.decimals < spec.inputDecimals)
+    {
+        long long divider = fixedPow10[spec.inputDecimals - spec.decimals];
+        magnitude = (magnitude * 2 + divider) / (divider * 2);
+    }
+    else
+        magnitude *= fixedPow10[spec.decimals - spec.inputDecimals];
+
+    char number[32];
+    const char *sign = value < 0 && magnitude > 0 ? "-" : "";
+    if (spec.decimals > 0)
+        snprintf(number, sizeof(number), "%s%lld.%0*lld", sign, magnitude / fixedPow10[spec.decimals],
+                 spec.decimals, magnitude % fixedPow10[spec.decimals]);
+    else
+        snprintf(number, sizeof(number), "%s%lld", sign, magnitude);
+
+    if (strlen(number) > spec.width || magnitude > 0xFFFFFFFFLL)
+    {
+        memset(text, '#', spec.width);
+        text[spec.width] = 0;
+    }
+    else
+        snprintf(text, 32, "%*s", spec.width, number);
+    strcat(text, spec.unit);
+}
+
+int main()
+{
+    // ROUNDING, half away from zero on both sides
+    EXPECT_FORMAT(3715, (FixedFormat{5, 2, 3, "V"}), " 3.72V");
+    EXPECT_FORMAT(3714, (FixedFormat{5, 2, 3, "V"}), " 3.71V");
+    EXPECT_FORMAT(-3715, (FixedFormat{5, 2, 3, "V"}), "-3.72V");
+    EXPECT_FORMAT(15, (FixedFormat{2, 0, 1, ""}), " 2");
+    EXPECT_FORMAT(-15, (FixedFormat{2, 0, 1, ""}), "-2");
+    EXPECT_FORMAT(14, (FixedFormat{2, 0, 1, ""}), " 1");
+
+    // NEGATIVE ZERO, -0.004 is 0.00 but -0.005 rounds away to -0.01
+    EXPECT_FORMAT(-4, (FixedFormat{5, 2, 3, "V"}), " 0.00V");
+    EXPECT_FORMAT(-5, (FixedFormat{5, 2, 3, "V"}), "-0.01V");
+    EXPECT_FORMAT(0, (FixedFormat{4, 1, 1, "km"}), " 0.0km");
+
+    // PADDING AND EXTRA DECIMALS
+    EXPECT_FORMAT(7, (FixedFormat{5, 2, 0, ""}), " 7.00");
+    EXPECT_FORMAT(5, (FixedFormat{4, 2, 0, ""}), "5.00");
+    EXPECT_FORMAT(123, (FixedFormat{4, 1, 1, ""}), "12.3");
+    EXPECT_FORMAT(-105, (FixedFormat{4, 0, 0, "rssi"}), "-105rssi");
+
+    // OVERFLOW, the whole width turns to '#', including when rounding adds a digit
+    EXPECT_FORMAT(99994, (FixedFormat{5, 2, 3, "V"}), "99.99V");
+    EXPECT_FORMAT(99995, (FixedFormat{5, 2, 3, "V"}), "#####V");
+    EXPECT_FORMAT(12345, (FixedFormat{4, 1, 1, ""}), "####");
+    EXPECT_FORMAT(-1050, (FixedFormat{3, 0, 0, ""}), "###");
+    EXPECT_FORMAT(50000000, (FixedFormat{12, 2, 0, ""}), "############");
+
+    // INT32 LIMITS
+    EXPECT_FORMAT(INT32_MIN, (FixedFormat{12, 0, 0, ""}), " -2147483648");
+    EXPECT_FORMAT(INT32_MIN, (FixedFormat{11, 0, 0, ""}), "-2147483648");
+    EXPECT_FORMAT(INT32_MIN, (FixedFormat{10, 0, 0, ""}), "##########");
+    EXPECT_FORMAT(INT32_MAX, (FixedFormat{5, 0, 3, ""}), "#####");
+    EXPECT_FORMAT(INT32_MAX, (FixedFormat{8, 0, 3, ""}), " 2147484");
+    EXPECT_FORMAT(INT32_MIN, (FixedFormat{12, 1, 0, ""}), "############");
+
+    // RANDOM against the reference, magnitudes spread over every digit count
+    std::mt19937 rng(13);
+    for (int i = 0; i < 500000; i++)
+    {
+        int32_t value = (int32_t)(rng() >> (rng() % 32));
+        if (rng() & 1)
+            value = -value;
+        FixedFormat spec = {(uint8_t)(1 + rng() % 13), (uint8_t)(rng() % 5), (uint8_t)(rng() % 5), rng() & 1 ? "Wh" : ""};
+        char expected[48];
+        Reference(expected, value, spec);
+        EXPECT_FORMAT(value, spec, expected);
+        if (hostFailures > 10)
+            break;
+    }
+
+    return hostTestResult("fixedFormatTest");
+}
@@ -0,0 +1,127 @@
+//FRAME SCHEDULER UNDER A SIMULATED LOOP
+//Drives FrameScheduler::Due() on the host clock with a loop() that costs 40-250us per pass, plus the blocking calls
+//the remote really has: the LED strip show() and a full OLED redraw. Checks that frames stay on the start + n * interval
+//grid (no drift), that the long run rate is 1/interval, that a stall is followed by at most one catch-up frame (no
+//burst) and that missed frames are counted.
+//CSV: case, interval us, frames sent, frames expected, missed frames, p50 lateness us, p99 us, max us
+
+#include "frameScheduler.h"
+#include "hostTest.h"
+#include <random>
+#include <vector>
+
+const unsigned long simDurationUs = 20000000;
+const unsigned long frameSendUs = 150;
+const unsigned long loopMinUs = 40;
+const unsigned long loopMaxUs = 250;
+
+struct SimCase
+{
+    const char *name;
+    uint32_t intervalUs;
+    unsigned long ledPeriodUs, ledStallUs;   // strip show() with interrupts off
+    unsigned long oledPeriodUs, oledStallUs; // full screen redraw over I2C
+};
+
+static void runCase(const SimCase &simCase)
+{
+    hostSetMicros(1000);
+    std::mt19937 rng(5);
+    FrameScheduler scheduler;
+    scheduler.Setup(simCase.intervalUs);
+
+    const uint32_t interval = simCase.intervalUs;
+    const unsigned long start = micros();
+    unsigned long nextLed = start + simCase.ledPeriodUs;
+    unsigned long nextOled = start + simCase.oledPeriodUs;
+    // Worst pass: a frame, the loop body, and both the LED and the OLED landing on it
+    unsigned long longestStall = frameSendUs + loopMaxUs + simCase.ledStallUs + simCase.oledStallUs;
+
+    std::vector<unsigned long> frames;
+    // Grid the frames should sit on, moved only when the scheduler re-phases after missing whole frames
+    unsigned long gridStart = start;
+    uint32_t gridFrame = 0;
+    uint32_t missedSeen = 0;
+    bool onGrid = true;
+
+    while (micros() - start < simDurationUs)
+    {
+        unsigned long now = micros();
+        if (scheduler.Due(now))
+        {
+            frames.push_back(now);
+            if (scheduler.missedFrames != missedSeen)
+            {
+                missedSeen = scheduler.missedFrames;
+                gridStart = now;
+                gridFrame = 0;
+            }
+            else
+            {
+                gridFrame++;
+                long offset = (long)(now - gridStart) - (long)gridFrame * interval;
+                if (offset < 0 || offset >= (long)interval)
+                    onGrid = false;
+            }
+            hostAdvanceMicros(frameSendUs);
+        }
+
+        hostAdvanceMicros(loopMinUs + rng() % (loopMaxUs - loopMinUs + 1));
+        if (simCase.ledPeriodUs && (long)(micros() - nextLed) >= 0)
+        {
+            hostAdvanceMicros(simCase.ledStallUs);
+            nextLed += simCase.ledPeriodUs;
+        }
+        if (simCase.oledPeriodUs && (long)(micros() - nextOled) >= 0)
+        {
+            hostAdvanceMicros(simCase.oledStallUs);
+            nextOled += simCase.oledPeriodUs;
+        }
+    }
+
+    uint32_t expected = simDurationUs / interval;
+    uint32_t sent = frames.size();
+    printf("%s,%u,%u,%u,%u,%u,%u,%u\n", simCase.name, interval, sent, expected, scheduler.missedFrames,
+           scheduler.LatenessPercentile(50), scheduler.LatenessPercentile(99), scheduler.maxLateness);
+
+    CHECK(onGrid);
+    CHECK(scheduler.maxLateness <= longestStall);
+    // At most two frames in any interval: a late frame may be followed by the on time one, never by a backlog
+    bool burst = false;
+    for (size_t i = 2; i < frames.size(); i++)
+        if (frames[i] - frames[i - 2] < interval)
+            burst = true;
+    CHECK(!burst);
+
+    if (longestStall < interval)
+    {
+        // Nothing ever costs a whole frame: every deadline gets its frame and the rate is exactly 1/interval
+        CHECK_EQ(scheduler.missedFrames, 0);
+        CHECK(sent + 1 >= expected && sent <= expected);
+    }
+    else
+    {
+        // Frames lost in stalls are counted, and each re-phase gives up less than one interval of the grid
+        uint32_t stalls = simDurationUs / simCase.oledPeriodUs;
+        CHECK(scheduler.missedFrames > 0);
+        CHECK(sent + scheduler.missedFrames <= expected);
+        CHECK(sent + scheduler.missedFrames + stalls + 1 >= expected);
+    }
+}
+
+int main()
+{
+    const SimCase cases[] = {
+        {"steady 250Hz", 4000, 0, 0, 0, 0},
+        {"steady 500Hz", 2000, 0, 0, 0, 0},
+        {"led 250Hz", 4000, 20000, 2500, 0, 0},
+        {"led+oled 250Hz", 4000, 20000, 2500, 250000, 12000},
+        {"led+oled 500Hz", 2000, 20000, 1500, 250000, 15000},
+    };
+
+    printf("case,interval us,frames,expected,missed,p50 us,p99 us,max us\n");
+    for (const SimCase &simCase : cases)
+        runCase(simCase);
+    hostRealClock();
+    return hostTestResult("frameSchedulerSim");
+}
@@ -0,0 +1,33 @@
+#ifndef HOSTTEST_H
+#define HOSTTEST_H
+
+#include <stdio.h>
+
+//CHECKS FOR THE HOST TESTS, a failing check prints where it failed and the test exits nonzero
+
+static int hostFailures = 0;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            hostFailures++;                                             \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        }                                                               \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                  \
+    do {                                                                \
+        long long _a = (long long)(a), _b = (long long)(b);             \
+        if (_a != _b) {                                                 \
+            hostFailures++;                                             \
+            printf("%s:%d: %s == %s failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+        }                                                               \
+    } while (0)
+
+static inline int hostTestResult(const char *name)
+{
+    printf("%s: %s\n", name, hostFailures ? "FAILED" : "ok");
+    return hostFailures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,196 @@
+//LED ANIMATION MATH
+//Compares the fixed point waveforms in led.h with the float code UpdateLed() and HSVToRGB() used before: LedSine()
+//against sin() over every phase, LedLerp() against a float lerp over every a, b and blend, the idle and brake pulses,
+//the brake phase step and HSVToRGB() over every hue, saturation and value. Then times one animation update each way.
+//CSV: function, cases, max error, allowed
+//CSV: update, old float ns, new fixed point ns
+
+#include "led.h"
+#include "hostTest.h"
+#include <chrono>
+
+const double ledPhaseToRad = 2.0 * PI / 65536.0;
+const int benchUpdates = 1000000;
+const int benchRepeats = 5;
+
+//THE FLOAT VERSIONS, as UpdateLed() and led.h had them
+static float lerp(float a, float b, float x)
+{
+    return a + x * (b - a);
+}
+
+static float clamp(float x, float xMin, float xMax)
+{
+    if (x < xMin)
+        return xMin;
+    if (x > xMax)
+        return xMax;
+    return x;
+}
+
+static RGB floatHSVToRGB(HSV hsv)
+{
+    RGB rgb;
+    float h = hsv.h * 360.0 / 255.0;
+    float s = hsv.s / 255.0;
+    float v = hsv.v / 255.0;
+
+    float c = v * s;
+    float x = c * (1 - fabs(fmod(h / 60.0, 2) - 1));
+    float m = v - c;
+
+    float r_prime, g_prime, b_prime;
+    if (h >= 0 && h < 60) {
+        r_prime = c; g_prime = x; b_prime = 0;
+    } else if (h >= 60 && h < 120) {
+        r_prime = x; g_prime = c; b_prime = 0;
+    } else if (h >= 120 && h < 180) {
+        r_prime = 0; g_prime = c; b_prime = x;
+    } else if (h >= 180 && h < 240) {
+        r_prime = 0; g_prime = x; b_prime = c;
+    } else if (h >= 240 && h < 300) {
+        r_prime = x; g_prime = 0; b_prime = c;
+    } else {
+        r_prime = c; g_prime = 0; b_prime = x;
+    }
+
+    rgb.r = (r_prime + m) * 255.0;
+    rgb.g = (g_prime + m) * 255.0;
+    rgb.b = (b_prime + m) * 255.0;
+    return rgb;
+}
+
+static void report(const char *name, long cases, double maxError, double allowed)
+{
+    printf("%s,%ld,%.2f,%.2f\n", name, cases, maxError, allowed);
+    CHECK(maxError <= allowed);
+}
+
+static void checkAccuracy()
+{
+    double sineError = 0, idleError = 0, brakeError = 0;
+    for (uint32_t phase = 0; phase < 65536; phase++)
+    {
+        double s = sin(phase * ledPhaseToRad);
+        sineError = max(sineError, fabs(LedSine(phase) - s * ledSineOne));
+        idleError = max(idleError, fabs(LedIdlePulse(phase) - clamp(s * 4 - 3, 0, 1) * 256));
+        brakeError = max(brakeError, fabs(LedBrakePulse(phase) - (s * 0.5 + 0.5) * 256));
+    }
+    // Linear between 257 entries is off by at most (2*PI/256)^2/8 of full scale (2.5 LSB), plus rounding
+    report("LedSine", 65536, sineError, 4);
+    report("LedIdlePulse", 65536, idleError, 2);
+    report("LedBrakePulse", 65536, brakeError, 1.5); // truncates, so up to one step below
+    CHECK_EQ(LedSine(0), 0);
+    CHECK_EQ(LedSine(16384), ledSineOne);
+    CHECK_EQ(LedSine(49152), -ledSineOne);
+
+    double lerpError = 0;
+    for (int a = 0; a < 256; a++)
+        for (int b = 0; b < 256; b++)
+            for (int t = 0; t <= 256; t++)
+                lerpError = max(lerpError, fabs(LedLerp(a, b, t) - lerp(a, b, t / 256.0f)));
+    report("LedLerp", 256L * 256 * 257, lerpError, 1);
+    CHECK_EQ(LedLerp(17, 200, 0), 17);
+    CHECK_EQ(LedLerp(17, 200, 256), 200);
+    CHECK_EQ(LedLerp(200, 17, 256), 17);
+
+    double stepError = 0;
+    // UpdateLed() only brakes below -100 permille
+    for (int permille = -1000; permille <= -100; permille++)
+        stepError = max(stepError, fabs(LedBrakePhaseStep(permille) - (0.005 - 0.015 * permille / 1000.0) * 4 / ledPhaseToRad));
+    report("LedBrakePhaseStep", 901, stepError, 1);
+    CHECK(fabs(ledIdlePhaseStep - 0.01 / ledPhaseToRad) <= 0.5);
+
+    double hsvError = 0;
+    for (int h = 0; h < 256; h++)
+        for (int s = 0; s < 256; s++)
+            for (int v = 0; v < 256; v++)
+            {
+                HSV hsv = {(byte)h, (byte)s, (byte)v};
+                RGB fixed = HSVToRGB(hsv);
+                RGB reference = floatHSVToRGB(hsv);
+                hsvError = max(hsvError, (double)abs(fixed.r - reference.r));
+                hsvError = max(hsvError, (double)abs(fixed.g - reference.g));
+                hsvError = max(hsvError, (double)abs(fixed.b - reference.b));
+            }
+    report("HSVToRGB", 256L * 256 * 256, hsvError, 1);
+}
+
+//ONE UPDATE EACH WAY, idle and brake as UpdateLed() runs them, and one HSV conversion
+volatile uint32_t benchSink;
+
+static double nsPerUpdate(void (*update)(int))
+{
+    double best = 1e9;
+    for (int repeat = 0; repeat < benchRepeats; repeat++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < benchUpdates; i++)
+            update(i);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best = min(best, ns / benchUpdates);
+    }
+    return best;
+}
+
+static float benchTime = 0;
+static uint16_t benchPhase = 0;
+
+static void oldIdle(int)
+{
+    benchTime += 0.01f;
+    float anim = clamp(sin(benchTime) * 4 - 3, 0, 1);
+    RGB rgb = {(byte)lerp(0, 30, anim), (byte)lerp(0, 40, anim), (byte)lerp(0, 30, anim)};
+    if (benchTime > 10000.0f)
+        benchTime = 0;
+    benchSink = rgb.r + rgb.g + rgb.b;
+}
+
+static void newIdle(int)
+{
+    benchPhase += ledIdlePhaseStep;
+    uint16_t anim = LedIdlePulse(benchPhase);
+    RGB rgb = {LedLerp(0, 30, anim), LedLerp(0, 40, anim), LedLerp(0, 30, anim)};
+    benchSink = rgb.r + rgb.g + rgb.b;
+}
+
+static void oldBrake(int i)
+{
+    float throttle = -0.1f - (i & 1023) / 1137.0f;
+    benchTime += (0.005f - 0.015f * throttle) * 4;
+    float anim = sin(benchTime) * 0.5f + 0.5f;
+    if (benchTime > 10000.0f)
+        benchTime = 0;
+    benchSink = (byte)lerp(0, 255, anim);
+}
+
+static void newBrake(int i)
+{
+    int16_t throttlePermille = -100 - (i & 1023) * 1000 / 1137;
+    benchPhase += LedBrakePhaseStep(throttlePermille);
+    benchSink = LedLerp(0, 255, LedBrakePulse(benchPhase));
+}
+
+static void oldHsv(int i)
+{
+    RGB rgb = floatHSVToRGB({(byte)i, (byte)(i >> 8), 255});
+    benchSink = rgb.r + rgb.g + rgb.b;
+}
+
+static void newHsv(int i)
+{
+    RGB rgb = HSVToRGB({(byte)i, (byte)(i >> 8), 255});
+    benchSink = rgb.r + rgb.g + rgb.b;
+}
+
+int main()
+{
+    printf("function,cases,max error,allowed\n");
+    checkAccuracy();
+
+    printf("update,old float ns,new fixed point ns\n");
+    printf("idle,%.1f,%.1f\n", nsPerUpdate(oldIdle), nsPerUpdate(newIdle));
+    printf("brake,%.1f,%.1f\n", nsPerUpdate(oldBrake), nsPerUpdate(newBrake));
+    printf("HSVToRGB,%.1f,%.1f\n", nsPerUpdate(oldHsv), nsPerUpdate(newHsv));
+    return hostTestResult("ledAnimationTest");
+}
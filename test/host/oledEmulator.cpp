@@ -0,0 +1,122 @@
+//OLED PAGES ON AN EMULATED PANEL
+//Runs the screen pages and the tile queue unchanged against the U8X8 stand-in: every entry of screenPages[] gets a
+//few seconds of a made up ride at 250Hz frames, with what's left of each 4ms frame as the tile budget.
+//Checks that the panel ends up showing exactly the formatted values, prints the bus cost per page.
+//CSV: page, updates, tiles sent, tiles unchanged, bus bytes, bytes/update, max full refresh us
+
+#include "oledScreen.h"
+#include "hostTest.h"
+
+const unsigned long frameUs = 4000;
+const unsigned long frameWorkUs = 600;  // CRSF, ADC and the rest of a loop pass, not available to the screen
+const unsigned long pageMs = 3000;
+const unsigned long rideStepMs = 250;
+
+static int32_t ValueOf(OledScreenMenu &menu, uint8_t value)
+{
+    switch (value)
+    {
+        case VALUE_VOLTAGE: return menu.voltage;
+        case VALUE_DISTANCE: return menu.distance;
+        case VALUE_SPEED: return menu.speed;
+        case VALUE_CURRENT: return menu.current;
+        case VALUE_LINK_QUALITY: return menu.linkQuality;
+        case VALUE_RSSI: return menu.rssi;
+        case VALUE_TEMP_ESC: return menu.tempEsc;
+        case VALUE_TEMP_MOTOR: return menu.tempMotor;
+        case VALUE_MAX_SPEED: return menu.maxSpeed;
+        case VALUE_MAX_CURRENT: return menu.maxCurrent;
+        case VALUE_WATT_HOURS: return menu.wattHours;
+        case VALUE_WH_PER_DISTANCE: return menu.whPerDistance;
+    }
+    return 0;
+}
+
+// SAME MADE UP RIDE AS OLED_SCREEN_DEMO, every digit count and sign shows up
+static void StepRide(OledScreenMenu &menu, unsigned long t)
+{
+    menu.voltage = 3300 + (t / 7) % 900;
+    menu.distance = t / 1000;
+    menu.speed = (t * 7) % 45000;
+    menu.current = (int32_t)((t / 3) % 1200) - 200;
+    menu.tempEsc = 200 + (t / 50) % 700;
+    menu.tempMotor = (int32_t)((t / 30) % 1300) - 100;
+    menu.linkQuality = 100 - (t / 100) % 101;
+    menu.rssi = -(int32_t)((t / 40) % 121);
+    menu.maxSpeed = max(menu.maxSpeed, menu.speed);
+    menu.maxCurrent = max(menu.maxCurrent, menu.current);
+    menu.wattHours = t / 20;
+    menu.whPerDistance = 50 + (t / 10) % 400;
+    menu.remoteBatteryPercent = 100 - (t / 100) % 101;
+}
+
+// THE PANEL HAS TO SHOW label + number + unit of both rows, the battery cell is left out
+static void CheckPanel(OledScreenMenu &menu, int mode)
+{
+    const ScreenPage &page = screenPages[mode];
+    for (int y = 0; y < screenTextHeight; y++)
+    {
+        const ScreenRow &row = page.rows[y];
+        char expected[screenTextWidth + 8];
+        int len = strlen(row.label);
+        memcpy(expected, row.label, len);
+        len += formatFixed(expected + len, ValueOf(menu, row.value), *row.format);
+        while (len < screenTextWidth)
+            expected[len++] = ' ';
+        for (int x = 0; x < screenTextWidth; x++)
+        {
+            if (y == 0 && x == page.batteryColumn)
+                continue;
+            if (u8x8.Text(x, y) != expected[x])
+            {
+                hostFailures++;
+                printf("page %d row %d col %d: panel '%c', expected '%c'\n", mode, y, x, u8x8.Text(x, y), expected[x]);
+            }
+        }
+    }
+}
+
+OledScreenMenu menu;
+
+int main()
+{
+    hostSetMicros(0);
+    menu.Setup(0, 0, true);
+    menu.Flush();
+
+    printf("page,updates,tiles sent,tiles unchanged,bus bytes,bytes/update,max refresh us\n");
+    for (int mode = 0; mode <= SCREEN_MAX_MODES; mode++)
+    {
+        menu.SetMode(mode);
+        menu.display.ResetStats();
+        unsigned long bytesBefore = u8x8.busBytes;
+        unsigned long start = micros();
+        unsigned long updates = 0;
+        unsigned long rideMillis = 0;
+        for (unsigned long frame = start; micros() - start < pageMs * 1000UL; frame += frameUs)
+        {
+            // A SLOW TILE CAN RUN PAST THE FRAME, the next one starts from there
+            if (micros() < frame)
+                hostSetMicros(frame);
+            hostAdvanceMicros(frameWorkUs);
+            if (millis() - rideMillis >= rideStepMs)
+            {
+                rideMillis = millis();
+                StepRide(menu, millis());
+            }
+            unsigned long elapsed = micros() - frame;
+            menu.Update(elapsed < frameUs ? frameUs - elapsed : 0);
+            updates++;
+        }
+        menu.Flush();
+        CheckPanel(menu, mode);
+
+        OledTileDriver &display = menu.display;
+        unsigned long bytes = u8x8.busBytes - bytesBefore;
+        CHECK_EQ(bytes, display.BusBytes());
+        printf("%d,%lu,%lu,%lu,%lu,%.1f,%lu\n", mode, updates, display.tilesSent, display.tilesUnchanged, bytes,
+               (double)bytes / updates, display.maxRefreshUs);
+    }
+
+    return hostTestResult("oledEmulator");
+}
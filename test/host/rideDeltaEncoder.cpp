@@ -0,0 +1,35 @@
+//RECEIVER SIDE OF rideDeltaTest
+//The receiver's crsfTelemetry.h on the AlfredoCRSF stand-in, in its own translation unit because its CRSF types
+//and names clash with the remote's crsf.h.
+
+#include "crsfTelemetry.h"
+#include "rideDeltaEncoder.h"
+
+void rideEncode(const float values[RIDE_ENCODER_FIELDS], uint8_t keyframeInterval, uint8_t &type, std::vector<uint8_t> &payload)
+{
+    crsf.queued.clear();
+    if (keyframeInterval)
+        sendRideDelta(values[0], values[1], values[2], values[3], values[4], values[5], values[6], keyframeInterval);
+    else
+        sendRidePacked(values[0], values[1], values[2], values[3], values[4], values[5], values[6]);
+    type = crsf.queued.back().type;
+    payload = crsf.queued.back().payload;
+}
+
+void rideQuantize(const float values[RIDE_ENCODER_FIELDS], int32_t raw[RIDE_ENCODER_FIELDS])
+{
+    quantizeRide(values, raw);
+}
+
+void rideSetLinkUp(bool up)
+{
+    crsf.linkUp = up;
+}
+
+void rideEncoderReboot()
+{
+    rideKeySeq = 0;
+    rideFramesSinceKey = 0;
+    rideKeyDue = true;
+    crsf.linkUp = true;
+}
@@ -0,0 +1,19 @@
+#ifndef RIDEDELTAENCODER_H
+#define RIDEDELTAENCODER_H
+
+#include <stdint.h>
+#include <vector>
+
+//RECEIVER RIDE FRAME ENCODER FOR THE HOST TESTS, see rideDeltaEncoder.cpp
+
+#define RIDE_ENCODER_FIELDS 7
+
+//One ride frame as the receiver queues it: ArduPilot frame type, payload from the extended header on
+//(keyframeInterval 0 sends the plain packed frame)
+void rideEncode(const float values[RIDE_ENCODER_FIELDS], uint8_t keyframeInterval, uint8_t &type, std::vector<uint8_t> &payload);
+void rideQuantize(const float values[RIDE_ENCODER_FIELDS], int32_t raw[RIDE_ENCODER_FIELDS]);
+void rideSetLinkUp(bool up);
+//Power cycle: keyframe sequence starts over
+void rideEncoderReboot();
+
+#endif
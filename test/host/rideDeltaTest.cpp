@@ -0,0 +1,217 @@
+//RIDE KEYFRAMES AND DELTAS, RECEIVER TO REMOTE
+//The receiver's encoder (rideDeltaEncoder.cpp) feeds the remote's CRSF parser through the wire format the TX module
+//forwards. A made up ride runs with random frame loss and link drops, every ride update the remote applies has to
+//equal what the receiver quantized, lost keyframes may only cost dropped deltas.
+//Then the stale sequence case: a receiver that reboots restarts its keyframe sequence, so after link loss a delta
+//must not be applied to the keyframe from before.
+//Temperatures: ESC and motor readings above the old 8 bit limit (107.5C) come through, only past 235.5C they are clamped.
+//CSV: loss %, ride frames, delivered, applied, deltas dropped, keyframes, avg payload bytes
+
+#include "crsf.h"
+#include "crsfCorpus.h"
+#include "fakeSerial.h"
+#include "hostTest.h"
+#include "rideDeltaEncoder.h"
+
+const uint8_t keyframeInterval = 8;
+const unsigned long rideFrameUs = 40000;
+const int linkStatsEvery = 5; // ride frames between link statistics
+
+struct RemoteLink
+{
+    FakeSerial serial;
+    CRSF crsf;
+    int32_t ride[RIDE_ENCODER_FIELDS];
+
+    RemoteLink() { crsf.begin(serial); }
+
+    // One frame through the parser, true if it changed the decoded telemetry
+    bool Deliver(uint8_t type, const std::vector<uint8_t> &payload)
+    {
+        CrsfCorpus frame;
+        crsfCorpusFrame(frame, type, payload.data(), payload.size());
+        uint32_t before = crsf._telemetry.sequence();
+        serial.Deliver(frame.bytes);
+        Poll();
+        return crsf._telemetry.sequence() != before;
+    }
+
+    // ELRS TX module's link statistics, uplink LQ 0 once it lost the receiver
+    void LinkStats(uint8_t uplinkLq)
+    {
+        std::vector<uint8_t> link = {70, 70, uplinkLq, 5, 0, 4, 2, 75, 100, 3};
+        Deliver(CRSF_FRAMETYPE_LINK_STATISTICS, link);
+    }
+
+    // Parser pass without new bytes, runs the link checks
+    void Poll()
+    {
+        do
+            crsf.handleSerialIn();
+        while (serial.available());
+    }
+
+    // Ride frame through the parser, true if the remote took it, ride holds the packed values it shows
+    bool Ride(const std::vector<uint8_t> &payload)
+    {
+        if (!Deliver(CRSF_FRAMETYPE_ARDUPILOT_RESP, payload))
+            return false;
+        crsfTelemetry_t telemetry;
+        crsf._telemetry.snapshot(telemetry);
+        const crsf_elrsk8_ride_t &r = telemetry.ride;
+        int32_t raw[RIDE_ENCODER_FIELDS] = {r.speed, r.current, r.cellVoltage, (r.tempEsc + 200) / 5, (r.tempMotor + 200) / 5, r.wattHours, (int32_t)r.distance};
+        memcpy(ride, raw, sizeof(ride));
+        return true;
+    }
+};
+
+// Slowly changing ride with an occasional current spike
+static void StepRide(float v[RIDE_ENCODER_FIELDS], std::mt19937 &rng)
+{
+    v[0] = constrain(v[0] + (int)(rng() % 21 - 10) / 10.0f, 0.0f, 60.0f);
+    v[1] += (int)(rng() % 41 - 20) / 10.0f;
+    if (rng() % 200 == 0)
+        v[1] = (int)(rng() % 600) - 100;
+    v[2] -= 0.00001f;
+    v[3] += (int)(rng() % 3 - 1) * 0.05f;
+    v[4] += (int)(rng() % 3 - 1) * 0.05f;
+    v[5] += 0.003f;
+    v[6] += 0.0005f;
+}
+
+static void LossRun(int lossPercent)
+{
+    RemoteLink remote;
+    rideEncoderReboot();
+    std::mt19937 rng(42);
+    float v[RIDE_ENCODER_FIELDS] = {0, 0, 4.1f, 25, 25, 0, 0};
+    long frames = 0, delivered = 0, applied = 0, keyframes = 0, bytes = 0;
+
+    for (int n = 0; n < 20000; n++)
+    {
+        hostAdvanceMicros(rideFrameUs);
+        StepRide(v, rng);
+        bool linkUp = n % 2000 < 1900; // 4 s without a link every 80 s
+        rideSetLinkUp(linkUp);
+
+        uint8_t type;
+        std::vector<uint8_t> payload;
+        rideEncode(v, keyframeInterval, type, payload);
+        frames++;
+        bytes += payload.size();
+        if (payload[2] == CRSF_ELRSK8_RIDE_KEY)
+            keyframes++;
+
+        if (!linkUp)
+        {
+            remote.Poll();
+            continue;
+        }
+        if (n % linkStatsEvery == 0)
+            remote.LinkStats(100);
+        if ((int)(rng() % 100) < lossPercent)
+            continue;
+        delivered++;
+        if (remote.Ride(payload))
+        {
+            applied++;
+            int32_t expected[RIDE_ENCODER_FIELDS];
+            rideQuantize(v, expected);
+            if (memcmp(remote.ride, expected, sizeof(expected)) != 0)
+            {
+                hostFailures++;
+                printf("loss %d%% frame %d: remote shows other values than the receiver sent\n", lossPercent, n);
+            }
+        }
+    }
+    CHECK(applied > 0);
+    CHECK_EQ(delivered, applied + remote.crsf._rxStats.rideDeltasDropped);
+    printf("%d,%ld,%ld,%ld,%u,%ld,%.2f\n", lossPercent, frames, delivered, applied, remote.crsf._rxStats.rideDeltasDropped, keyframes,
+           (double)bytes / frames);
+}
+
+enum LinkLoss { LOSS_NONE, LOSS_SILENT, LOSS_LQ_ZERO };
+
+// Keyframe and a delta get through, then the link goes (or not), the receiver reboots (or not), its first keyframe is
+// lost and the delta after it arrives carrying the same sequence number as the remote's old keyframe.
+// Returns whether the remote applied that delta.
+static bool StaleSequence(LinkLoss loss, unsigned long gapMs, bool reboot)
+{
+    RemoteLink remote;
+    rideEncoderReboot();
+    float v[RIDE_ENCODER_FIELDS] = {20, 10, 3.9f, 40, 50, 12, 3};
+    uint8_t type;
+    std::vector<uint8_t> payload;
+
+    remote.LinkStats(100);
+    rideEncode(v, keyframeInterval, type, payload);
+    CHECK_EQ(payload[2], CRSF_ELRSK8_RIDE_KEY);
+    CHECK(remote.Ride(payload));
+    v[0] += 1;
+    rideEncode(v, keyframeInterval, type, payload);
+    CHECK_EQ(payload[2], CRSF_ELRSK8_RIDE_DELTA);
+    CHECK(remote.Ride(payload));
+
+    if (loss == LOSS_LQ_ZERO)
+        remote.LinkStats(0);
+    hostAdvanceMicros(gapMs * 1000);
+    remote.Poll();
+    if (loss != LOSS_NONE)
+        remote.LinkStats(100);
+
+    if (reboot)
+        rideEncoderReboot();
+    v[0] = 35;
+    v[5] = 80;
+    rideEncode(v, keyframeInterval, type, payload); // lost
+    if (reboot)
+        CHECK_EQ(payload[2], CRSF_ELRSK8_RIDE_KEY);
+    v[0] += 1;
+    rideEncode(v, keyframeInterval, type, payload);
+    CHECK_EQ(payload[2], CRSF_ELRSK8_RIDE_DELTA);
+    return remote.Ride(payload);
+}
+
+// ESC and motor temperature through a plain ride frame, returns what the remote shows in 0.1C
+static void RideTemps(float tempEsc, float tempMotor, int16_t &shownEsc, int16_t &shownMotor)
+{
+    RemoteLink remote;
+    float v[RIDE_ENCODER_FIELDS] = {20, 10, 3.9f, tempEsc, tempMotor, 12, 3};
+    uint8_t type;
+    std::vector<uint8_t> payload;
+    rideEncode(v, 0, type, payload);
+    CHECK(remote.Ride(payload));
+    crsfTelemetry_t telemetry;
+    remote.crsf._telemetry.snapshot(telemetry);
+    shownEsc = telemetry.ride.tempEsc;
+    shownMotor = telemetry.ride.tempMotor;
+}
+
+int main()
+{
+    hostSetMicros(1000000);
+
+    printf("loss %%,ride frames,delivered,applied,deltas dropped,keyframes,avg payload bytes\n");
+    for (int loss : {0, 10, 30, 60})
+        LossRun(loss);
+
+    // A SHORT GAP KEEPS THE KEYFRAME, the delta still belongs to it
+    CHECK(StaleSequence(LOSS_NONE, CRSF_LINK_LOST_MS / 2, false));
+    // REBOOT AFTER THE LINK WENT QUIET, or after the TX module reported the receiver lost: the delta is dropped
+    CHECK(!StaleSequence(LOSS_SILENT, CRSF_LINK_LOST_MS + 1000, true));
+    CHECK(!StaleSequence(LOSS_LQ_ZERO, 0, true));
+
+    // HOT ESC AND MOTOR, above 107.5C they used to stick there
+    int16_t shownEsc, shownMotor;
+    RideTemps(108.5f, 150.0f, shownEsc, shownMotor);
+    CHECK_EQ(shownEsc, 1085);
+    CHECK_EQ(shownMotor, 1500);
+    RideTemps(-20.0f, 235.5f, shownEsc, shownMotor);
+    CHECK_EQ(shownEsc, -200);
+    CHECK_EQ(shownMotor, 2355);
+    RideTemps(-40.0f, 300.0f, shownEsc, shownMotor);
+    CHECK_EQ(shownEsc, -200);
+    CHECK_EQ(shownMotor, 2355);
+
+    return hostTestResult("rideDeltaTest");
+}
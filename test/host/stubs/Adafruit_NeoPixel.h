@@ -0,0 +1,23 @@
+#ifndef ADAFRUIT_NEOPIXEL_H
+#define ADAFRUIT_NEOPIXEL_H
+
+#include <Arduino.h>
+
+//HOST STAND-IN, keeps the last color set, show() does nothing
+#define NEO_GRB 0x52
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel
+{
+public:
+    uint32_t color = 0;
+
+    Adafruit_NeoPixel(uint16_t count, int16_t pin, uint16_t type) { (void)count; (void)pin; (void)type; }
+    void setPin(int16_t pin) { (void)pin; }
+    void begin() {}
+    void show() {}
+    void setPixelColor(uint16_t n, uint32_t c) { (void)n; color = c; }
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) { return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b; }
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef ALFREDOCRSF_H
+#define ALFREDOCRSF_H
+
+//HOST STAND-IN FOR AlfredoCRSF
+//The frame types and sensor structs the receiver sketch uses, and a CRSF object that keeps every queued packet
+//(type + payload) instead of sending it. Tests set linkUp to play a lost link.
+
+#include <Arduino.h>
+#include <endian.h>
+#include <vector>
+
+#define PACKED __attribute__((packed))
+#define CRSF_BAUDRATE 420000
+#define CRSF_SYNC_BYTE 0xC8
+
+enum
+{
+    CRSF_FRAMETYPE_GPS = 0x02,
+    CRSF_FRAMETYPE_VARIO = 0x07,
+    CRSF_FRAMETYPE_BATTERY_SENSOR = 0x08,
+    CRSF_FRAMETYPE_BARO_ALTITUDE = 0x09,
+    CRSF_FRAMETYPE_LINK_STATISTICS = 0x14,
+    CRSF_FRAMETYPE_RC_CHANNELS_PACKED = 0x16,
+    CRSF_FRAMETYPE_ATTITUDE = 0x1E,
+};
+
+enum
+{
+    CRSF_ADDRESS_FLIGHT_CONTROLLER = 0xC8,
+    CRSF_ADDRESS_RADIO_TRANSMITTER = 0xEA,
+};
+
+typedef struct { int32_t latitude; int32_t longitude; uint16_t groundspeed; uint16_t heading; uint16_t altitude; uint8_t satellites; } PACKED crsf_sensor_gps_t;
+typedef struct { int16_t verticalspd; } PACKED crsf_sensor_vario_t;
+typedef struct { uint16_t altitude; int16_t verticalspd; } PACKED crsf_sensor_baro_altitude_t;
+typedef struct { int16_t pitch; int16_t roll; int16_t yaw; } PACKED crsf_sensor_attitude_t;
+typedef struct { unsigned voltage : 16; unsigned current : 16; unsigned capacity : 24; unsigned remaining : 8; } PACKED crsf_sensor_battery_t;
+
+struct HostCrsfPacket
+{
+    uint8_t type;
+    std::vector<uint8_t> payload;
+};
+
+class AlfredoCRSF
+{
+public:
+    bool linkUp = true;
+    std::vector<HostCrsfPacket> queued;
+
+    void begin(Stream &port) { (void)port; }
+    void update() {}
+    int getChannel(unsigned int channel) { (void)channel; return 992; }
+    bool isLinkUp() const { return linkUp; }
+
+    void queuePacket(uint8_t addr, uint8_t type, const void *payload, uint8_t len)
+    {
+        (void)addr;
+        const uint8_t *bytes = (const uint8_t *)payload;
+        queued.push_back({type, std::vector<uint8_t>(bytes, bytes + len)});
+    }
+};
+
+#endif
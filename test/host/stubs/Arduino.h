@@ -0,0 +1,105 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+//HOST STAND-IN FOR THE ARDUINO CORE
+//Just enough of Arduino.h for the sketch headers and crsf.cpp to build on a PC.
+//The clock runs in real time for benchmarks, or is set by the test (hostSetMicros) for timing checks.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define D1 1
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define PI 3.1415926535897932384626433832795
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+
+template <class T, class U> auto min(T a, U b) -> decltype(a + b) { return a < b ? a : b; }
+template <class T, class U> auto max(T a, U b) -> decltype(a + b) { return a > b ? a : b; }
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) { return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin; }
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+int analogRead(int pin);
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+//HOST CLOCK CONTROL, manual once set, hostRealClock() goes back to the PC clock
+void hostSetMicros(unsigned long us);
+void hostAdvanceMicros(unsigned long us);
+void hostRealClock();
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t *buf, size_t len)
+    {
+        size_t n = 0;
+        while (len--)
+            n += write(*buf++);
+        return n;
+    }
+    virtual int availableForWrite() { return 0; } // same default as the Arduino core
+    size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+
+    size_t print(const char *s) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return print((long)v); }
+    size_t print(unsigned int v) { return print((unsigned long)v); }
+    size_t print(long v);
+    size_t print(unsigned long v);
+    size_t print(double v, int digits = 2);
+    template <class T> size_t println(T v) { return print(v) + println(); }
+    size_t println() { return write("\r\n"); }
+    void flush() {}
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+//USB SERIAL GOES TO STDOUT, the other ports drop everything
+class HardwareSerial : public Stream
+{
+public:
+    HardwareSerial(bool toStdout = false) : console(toStdout) {}
+    HardwareSerial(int rxPin, int txPin) : console(false) { (void)rxPin; (void)txPin; }
+    void begin(unsigned long baud) { (void)baud; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    size_t write(uint8_t b) override;
+    using Print::write;
+    int availableForWrite() override { return 64; }
+    operator bool() { return true; }
+
+private:
+    bool console;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef SIMPLEKALMANFILTER_H
+#define SIMPLEKALMANFILTER_H
+
+//HOST STAND-IN, passes measurements straight through
+class SimpleKalmanFilter
+{
+public:
+    SimpleKalmanFilter(float measurementError, float estimateError, float noise) { (void)measurementError; (void)estimateError; (void)noise; }
+    float updateEstimate(float measurement) { return measurement; }
+};
+
+#endif
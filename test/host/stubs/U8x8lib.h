@@ -0,0 +1,89 @@
+#ifndef U8X8LIB_H
+#define U8X8LIB_H
+
+//HOST STAND-IN FOR U8X8
+//Keeps what would be on the panel and counts tiles and I2C bytes. Each transfer advances the host clock by its
+//time on a 400kHz bus (9 clocks a byte), so time budgets behave like on the board.
+//The font is made up: the top tile of a glyph is its character code in all 8 columns, the bottom tile the code | 0x80,
+//so Text() can read the panel back as characters.
+
+#include <Arduino.h>
+
+#define U8X8_PIN_NONE 255
+#define U8X8_PROGMEM
+#define u8x8_pgm_read(adr) (*(const uint8_t *)(adr))
+
+struct U8x8HostFont
+{
+    uint8_t data[4 + 96 * 16];
+
+    constexpr U8x8HostFont() : data()
+    {
+        data[0] = 32;  // first
+        data[1] = 127; // last
+        data[2] = 1;   // tiles wide
+        data[3] = 2;   // tiles high
+        for (int c = 32; c < 128; c++)
+            for (int i = 0; i < 8; i++)
+            {
+                data[4 + (c - 32) * 16 + i] = c;
+                data[4 + (c - 32) * 16 + 8 + i] = c | 0x80;
+            }
+    }
+};
+
+inline constexpr U8x8HostFont u8x8HostFont;
+#define u8x8_font_8x13B_1x2_r (u8x8HostFont.data)
+
+const uint32_t u8x8HostBusHz = 400000;
+const uint8_t u8x8HostTileOverhead = 7; // address + 3 position commands, address + 2 control bytes
+
+class U8X8
+{
+public:
+    uint8_t panel[4][8][8];
+    unsigned long tileWrites = 0;
+    unsigned long busBytes = 0;
+
+    bool begin()
+    {
+        clear();
+        return true;
+    }
+
+    void clear()
+    {
+        memset(panel, 0, sizeof(panel));
+    }
+
+    void setFont(const uint8_t *font) { (void)font; }
+    void setBusClock(uint32_t hz) { (void)hz; }
+
+    void drawTile(uint8_t x, uint8_t y, uint8_t count, uint8_t *tiles)
+    {
+        for (uint8_t i = 0; i < count && x + i < 8 && y < 4; i++)
+            memcpy(panel[y][x + i], tiles + i * 8, 8);
+        unsigned long bytes = u8x8HostTileOverhead + 8UL * count;
+        tileWrites += count;
+        busBytes += bytes;
+        hostAdvanceMicros(bytes * 9 * 1000000UL / u8x8HostBusHz);
+    }
+
+    //CHARACTER AT TEXT CELL x, y (1x2 glyphs), '?' for anything that isn't a whole glyph of the host font
+    char Text(uint8_t x, uint8_t y)
+    {
+        uint8_t code = panel[y * 2][x][0];
+        for (int i = 0; i < 8; i++)
+            if (panel[y * 2][x][i] != code || panel[y * 2 + 1][x][i] != (code | 0x80))
+                return '?';
+        return code < 32 ? '?' : code;
+    }
+};
+
+class U8X8_SSD1306_64X32_1F_HW_I2C : public U8X8
+{
+public:
+    U8X8_SSD1306_64X32_1F_HW_I2C(uint8_t reset) { (void)reset; }
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include <Arduino.h>
+#include <chrono>
+#include <stdio.h>
+
+static const auto hostStart = std::chrono::steady_clock::now();
+static bool hostManualClock = false;
+static unsigned long hostMicrosValue = 0;
+
+unsigned long micros()
+{
+    if (hostManualClock)
+        return hostMicrosValue;
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - hostStart).count();
+}
+
+unsigned long millis() { return micros() / 1000; }
+
+void hostSetMicros(unsigned long us)
+{
+    hostManualClock = true;
+    hostMicrosValue = us;
+}
+
+void hostAdvanceMicros(unsigned long us) { hostSetMicros(hostMicrosValue + us); }
+void hostRealClock() { hostManualClock = false; }
+
+void delay(unsigned long ms) { delayMicroseconds(ms * 1000); }
+void delayMicroseconds(unsigned int us)
+{
+    if (hostManualClock)
+        hostMicrosValue += us;
+}
+
+int analogRead(int pin) { (void)pin; return 0; }
+void pinMode(int pin, int mode) { (void)pin; (void)mode; }
+void digitalWrite(int pin, int value) { (void)pin; (void)value; }
+int digitalRead(int pin) { (void)pin; return HIGH; }
+
+size_t Print::print(long v)
+{
+    char buf[24];
+    return write((const uint8_t *)buf, snprintf(buf, sizeof(buf), "%ld", v));
+}
+
+size_t Print::print(unsigned long v)
+{
+    char buf[24];
+    return write((const uint8_t *)buf, snprintf(buf, sizeof(buf), "%lu", v));
+}
+
+size_t Print::print(double v, int digits)
+{
+    char buf[48];
+    return write((const uint8_t *)buf, snprintf(buf, sizeof(buf), "%.*f", digits, v));
+}
+
+size_t HardwareSerial::write(uint8_t b)
+{
+    if (console && b != '\r')
+        putchar(b);
+    return 1;
+}
+
+HardwareSerial Serial(true);
+HardwareSerial Serial1;
+HardwareSerial Serial2;
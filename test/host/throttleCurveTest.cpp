@@ -0,0 +1,75 @@
+//THROTTLE CURVE TABLES
+//For a range of curve configs and both boards' calibrations: Map() never goes down as the ADC goes up, the ends are
+//exact (low -> full brake, mid -> mid, high -> max, past the ends clamped), and with a linear config it stays within
+//one channel step of the float mapping the sketch used before the tables.
+
+#include "throttleCurve.h"
+#include "hostTest.h"
+
+const int16_t outMin = 172;
+const int16_t outMid = 991;
+const int16_t outMax = 1811;
+
+// Throttle mapping before the curve tables, float and linear on each side of mid
+static float mapfloat(float x, float in_min, float in_max, float out_min, float out_max)
+{
+    return constrain((x - in_min) / (in_max - in_min), 0.0f, 1.0f) * (out_max - out_min) + out_min;
+}
+
+struct Calibration
+{
+    int low, mid, high, adcMax;
+};
+
+int main()
+{
+    const Calibration calibrations[] = {{670, 2165, 3650, 4095}, {4950, 8320, 11650, 16383}};
+    const ThrottleCurveConfig configs[] = {{0, 0, 0, 100}, {50, 30, 5, 100}, {100, 100, 10, 60}, {0, 0, 0, 0}, {30, 0, 20, 80}};
+
+    for (const Calibration &cal : calibrations)
+        for (const ThrottleCurveConfig &config : configs)
+        {
+            ThrottleCurve curve;
+            curve.Build(cal.low, cal.mid, cal.high, outMin, outMid, outMax, config);
+            int16_t brakeEnd = outMid - (int16_t)(((int32_t)(outMid - outMin) * config.maxBrake + 50) / 100);
+            bool linear = config.throttleExpo == 0 && config.brakeExpo == 0 && config.deadband == 0 && config.maxBrake == 100;
+
+            CHECK_EQ(curve.Map(cal.low), brakeEnd);
+            CHECK_EQ(curve.Map(cal.mid), outMid);
+            CHECK_EQ(curve.Map(cal.high), outMax);
+            CHECK_EQ(curve.Map(0), brakeEnd);
+            CHECK_EQ(curve.Map(cal.adcMax), outMax);
+
+            int previous = curve.Map(0);
+            int decreases = 0, maxLinearError = 0;
+            for (int adc = 0; adc <= cal.adcMax; adc++)
+            {
+                int value = curve.Map(adc);
+                if (value < previous)
+                    decreases++;
+                previous = value;
+                if (linear)
+                {
+                    float old = adc < cal.mid ? mapfloat(adc, cal.low, cal.mid, outMin, outMid) : mapfloat(adc, cal.mid, cal.high, outMid, outMax);
+                    maxLinearError = max(maxLinearError, abs((int)lroundf(old) - value));
+                }
+            }
+            CHECK_EQ(decreases, 0);
+            CHECK(maxLinearError <= 1);
+
+            // DEADBAND, flat up to the last table point inside it (the table smooths the edge over one segment)
+            int flatSegments = config.deadband * throttleCurveSegments / 100;
+            CHECK_EQ(curve.Map(cal.mid + (cal.high - cal.mid) * flatSegments / throttleCurveSegments), outMid);
+            CHECK_EQ(curve.Map(cal.mid - (cal.mid - cal.low) * flatSegments / throttleCurveSegments), outMid);
+        }
+
+    // NEAR, what CALIBRATION uses to skip rebuilding for ADC noise
+    ThrottleCurve curve;
+    CHECK(!curve.Near(670, 2165, 3650, 16));
+    curve.Build(670, 2165, 3650, outMin, outMid, outMax, configs[0]);
+    CHECK(curve.Near(670, 2165 + 16, 3650, 16));
+    CHECK(!curve.Near(670, 2165 - 17, 3650, 16));
+    CHECK(!curve.Near(670 - 17, 2165, 3650, 16));
+
+    return hostTestResult("throttleCurveTest");
+}
@@ -0,0 +1,323 @@
+//VESC POLLING AGAINST A FAKE VESC
+//The fake answers each request after a short turnaround, one byte every 87us (115200 baud) on the host clock, so
+//replies always arrive split over many update() calls. Checks the decoded values, that a broken reply (end byte,
+//CRC) is polled again on the next update() instead of after the poll interval, that a bad length recovers without a
+//timeout, and that a silent VESC times out and is asked again.
+//Selective polling: the request carries the mask, only those fields come back, and firmware that ignores
+//COMM_GET_VALUES_SELECTIVE gets the full command after VESC_SELECTIVE_MAX_MISSES timeouts.
+//Baseline: the loop the receiver had before the poller, VescUart's blocking getVescValues() then delay(10), against
+//the same fake. Prints loop iterations and replies per second for both.
+
+#include "vescPoller.h"
+#include "fakeSerial.h"
+#include "hostTest.h"
+#include <math.h>
+
+const unsigned long vescByteUs = 87;
+const unsigned long vescTurnaroundUs = 300;
+const unsigned long loopUs = 20;
+const uint32_t pollIntervalMs = 10;
+const uint32_t timeoutMs = 50;
+const unsigned long vescUartTimeoutMs = 100; // VescUart waits this long for a reply
+const unsigned long blockingPollUs = 5;      // one pass of its read loop
+
+//RAW FIELD VALUES ON THE WIRE, by mask bit (scaled the way the VESC sends them)
+const int32_t rawValues[VESC_VALUE_COUNT] = {453, -52, 1234, -567, 0, 0, 500, 23456, 487, 12345, 0, 987654, 0, -5, 99999, 0, 1000000, 7};
+
+enum Corruption { CORRUPT_NONE, CORRUPT_CRC, CORRUPT_END, CORRUPT_LENGTH };
+
+class FakeVesc : public FakeSerial
+{
+public:
+    bool answers = true;
+    bool answersSelective = true; // false: firmware without COMM_GET_VALUES_SELECTIVE, ignores it
+    Corruption corruptNext = CORRUPT_NONE;
+    int requestsSeen = 0;
+    std::vector<uint8_t> lastRequest;
+
+    int available() override
+    {
+        while (!pending.empty() && pendingDue.front() <= micros())
+        {
+            rx.push_back(pending.front());
+            pending.erase(pending.begin());
+            pendingDue.erase(pendingDue.begin());
+        }
+        return FakeSerial::available();
+    }
+
+    size_t write(uint8_t b) override
+    {
+        FakeSerial::write(b);
+        size_t len = tx.size() - requestStart;
+        if (len >= 2 && len == (size_t)tx[requestStart + 1] + 5)
+        {
+            lastRequest.assign(tx.begin() + requestStart, tx.end());
+            requestStart = tx.size();
+            requestsSeen++;
+            Answer();
+        }
+        return 1;
+    }
+    using Print::write;
+
+    static std::vector<uint8_t> Payload(uint8_t command, uint32_t fields)
+    {
+        std::vector<uint8_t> p = {command};
+        if (command == VESC_COMM_GET_VALUES_SELECTIVE)
+            for (int shift = 24; shift >= 0; shift -= 8)
+                p.push_back(fields >> shift);
+        for (int bit = 0; bit < VESC_VALUE_COUNT; bit++)
+            if (fields & (1UL << bit))
+                for (int k = vescValueSizes[bit] - 1; k >= 0; k--)
+                    p.push_back(rawValues[bit] >> (8 * k));
+        if (command == VESC_COMM_GET_VALUES)
+        {
+            p.push_back(0x11); // fields newer firmwares append
+            p.push_back(0x22);
+        }
+        return p;
+    }
+
+private:
+    size_t requestStart = 0;
+    std::vector<uint8_t> pending;
+    std::vector<unsigned long> pendingDue;
+
+    void Answer()
+    {
+        if (!answers)
+            return;
+        std::vector<uint8_t> p;
+        if (lastRequest[2] == VESC_COMM_GET_VALUES)
+            p = Payload(VESC_COMM_GET_VALUES, VESC_VALUES_ALL);
+        else if (lastRequest[2] == VESC_COMM_GET_VALUES_SELECTIVE && answersSelective)
+            p = Payload(VESC_COMM_GET_VALUES_SELECTIVE, (uint32_t)lastRequest[3] << 24 | (uint32_t)lastRequest[4] << 16 |
+                                                            (uint32_t)lastRequest[5] << 8 | lastRequest[6]);
+        else
+            return;
+        uint16_t crc = vescCrc16(p.data(), p.size());
+        std::vector<uint8_t> reply = {0x02, (uint8_t)p.size()};
+        reply.insert(reply.end(), p.begin(), p.end());
+        reply.push_back(crc >> 8);
+        reply.push_back(crc);
+        reply.push_back(0x03);
+        switch (corruptNext)
+        {
+            case CORRUPT_CRC: reply[10] ^= 0x40; break;
+            case CORRUPT_END: reply.back() = 0x02; break;
+            case CORRUPT_LENGTH: reply[1] = VESC_PACKET_MAX_PAYLOAD + 1; break;
+            default: break;
+        }
+        corruptNext = CORRUPT_NONE;
+        for (size_t i = 0; i < reply.size(); i++)
+        {
+            pending.push_back(reply[i]);
+            pendingDue.push_back(micros() + vescTurnaroundUs + (i + 1) * vescByteUs);
+        }
+    }
+};
+
+//LOOP FOR ms ON THE HOST CLOCK, returns decoded replies
+static int Run(VescPoller &poller, unsigned long ms)
+{
+    int decoded = 0;
+    for (unsigned long end = micros() + ms * 1000; micros() < end; hostAdvanceMicros(loopUs))
+        if (poller.update())
+            decoded++;
+    return decoded;
+}
+
+//UPDATE UNTIL THE NEXT BAD PACKET, returns the request count right after it
+static uint32_t RunToBadPacket(VescPoller &poller)
+{
+    uint32_t bad = poller.badPackets;
+    while (poller.badPackets == bad)
+    {
+        poller.update();
+        hostAdvanceMicros(loopUs);
+    }
+    return poller.requests;
+}
+
+//OLD RECEIVER LOOP FOR ms: getVescValues() sends the request and spins on the UART until the reply is in (or its
+//timeout), then loop() ends with delay(10). Returns loop iterations, replies counts good replies.
+static int RunBlocking(FakeVesc &vesc, unsigned long ms, int &replies)
+{
+    const uint8_t request[] = {0x02, 0x01, VESC_COMM_GET_VALUES, 0x40, 0x84, 0x03};
+    int iterations = 0;
+    replies = 0;
+    for (unsigned long end = micros() + ms * 1000; micros() < end; iterations++)
+    {
+        vesc.write(request, sizeof(request));
+        std::vector<uint8_t> reply;
+        unsigned long timeout = millis() + vescUartTimeoutMs;
+        while (millis() < timeout && (reply.size() < 2 || reply.size() < (size_t)reply[1] + 5u))
+        {
+            while (vesc.available())
+                reply.push_back(vesc.read());
+            hostAdvanceMicros(blockingPollUs);
+        }
+        if (reply.size() >= 2 && reply.size() == (size_t)reply[1] + 5u && reply.back() == 0x03)
+        {
+            uint16_t crc = vescCrc16(&reply[2], reply[1]);
+            if (reply[reply[1] + 2] == (crc >> 8) && reply[reply[1] + 3] == (crc & 0xff))
+                replies++;
+        }
+        hostAdvanceMicros(loopUs);
+        delay(10);
+    }
+    return iterations;
+}
+
+static void CheckFullValues(const vescData_t &d)
+{
+    CHECK(fabsf(d.tempMosfet - 45.3f) < 0.01f);
+    CHECK(fabsf(d.tempMotor + 5.2f) < 0.01f);
+    CHECK(fabsf(d.avgMotorCurrent - 12.34f) < 0.001f);
+    CHECK(fabsf(d.avgInputCurrent + 5.67f) < 0.001f);
+    CHECK(fabsf(d.dutyCycleNow - 0.5f) < 0.001f);
+    CHECK_EQ(d.rpm, 23456);
+    CHECK(fabsf(d.inpVoltage - 48.7f) < 0.01f);
+    CHECK(fabsf(d.ampHours - 1.2345f) < 0.0001f);
+    CHECK(fabsf(d.wattHours - 98.7654f) < 0.0001f);
+    CHECK_EQ(d.tachometer, -5);
+    CHECK_EQ(d.tachometerAbs, 99999);
+    CHECK(fabsf(d.pidPos - 1.0f) < 0.0001f);
+    CHECK_EQ(d.id, 7);
+}
+
+int main()
+{
+    hostSetMicros(1000000);
+
+    // FULL VALUES, split over many update() calls
+    {
+        FakeVesc vesc;
+        VescPoller poller;
+        poller.begin(vesc, pollIntervalMs, timeoutMs);
+        int decoded = Run(poller, 1000);
+        const uint8_t request[] = {0x02, 0x01, VESC_COMM_GET_VALUES, 0x40, 0x84, 0x03};
+        CHECK(vesc.lastRequest == std::vector<uint8_t>(request, request + sizeof(request)));
+        CHECK_EQ(decoded, poller.replies);
+        CHECK(decoded >= 1000 / (int)pollIntervalMs - 1);
+        CHECK_EQ(poller.timeouts, 0);
+        CHECK_EQ(poller.badPackets, 0);
+        CheckFullValues(poller.data);
+        printf("case,requests,replies,timeouts,bad packets\nfull,%u,%u,%u,%u\n", poller.requests, poller.replies,
+               poller.timeouts, poller.badPackets);
+    }
+
+    // BROKEN REPLIES, the next update() asks again instead of waiting out the poll interval
+    for (Corruption corruption : {CORRUPT_CRC, CORRUPT_END, CORRUPT_LENGTH})
+    {
+        FakeVesc vesc;
+        VescPoller poller;
+        poller.begin(vesc, pollIntervalMs, timeoutMs);
+        Run(poller, 100);
+        uint32_t replies = poller.replies;
+        vesc.corruptNext = corruption;
+        uint32_t requests = RunToBadPacket(poller);
+        poller.update();
+        // a bad length comes mid reply, the poller looks for the next start instead of asking into the rest of it
+        CHECK_EQ(poller.requests, corruption == CORRUPT_LENGTH ? requests : requests + 1);
+        CHECK_EQ(poller.timeouts, 0);
+        Run(poller, 20);
+        CHECK(poller.replies > replies);
+        CheckFullValues(poller.data);
+        printf("%s,%u,%u,%u,%u\n", corruption == CORRUPT_CRC ? "bad crc" : corruption == CORRUPT_END ? "bad end" : "bad length",
+               poller.requests, poller.replies, poller.timeouts, poller.badPackets);
+    }
+
+    // SILENT VESC, a timeout every request, asked again right after each
+    {
+        FakeVesc vesc;
+        vesc.answers = false;
+        VescPoller poller;
+        poller.begin(vesc, pollIntervalMs, timeoutMs);
+        Run(poller, 1000);
+        CHECK_EQ(poller.replies, 0);
+        CHECK(poller.timeouts >= 1000 / timeoutMs - 1);
+        CHECK(poller.requests <= poller.timeouts + 1);
+        vesc.answers = true;
+        CHECK(Run(poller, 100) > 0);
+        CheckFullValues(poller.data);
+        printf("timeouts,%u,%u,%u,%u\n", poller.requests, poller.replies, poller.timeouts, poller.badPackets);
+    }
+
+    // SELECTIVE, the receiver's mask: request carries it, only those fields come back and get decoded
+    const uint32_t mask = VESC_VALUE_TEMP_MOSFET | VESC_VALUE_TEMP_MOTOR | VESC_VALUE_INPUT_CURRENT | VESC_VALUE_RPM |
+                          VESC_VALUE_INPUT_VOLTAGE | VESC_VALUE_AMP_HOURS | VESC_VALUE_WATT_HOURS | VESC_VALUE_TACHOMETER_ABS;
+    {
+        FakeVesc vesc;
+        VescPoller poller;
+        poller.begin(vesc, pollIntervalMs, timeoutMs, mask);
+        Run(poller, 1000);
+        std::vector<uint8_t> request = {0x02, 0x05, VESC_COMM_GET_VALUES_SELECTIVE, 0x00, (uint8_t)(mask >> 16),
+                                        (uint8_t)(mask >> 8), (uint8_t)mask};
+        uint16_t crc = vescCrc16(&request[2], 5);
+        request.insert(request.end(), {(uint8_t)(crc >> 8), (uint8_t)crc, 0x03});
+        CHECK(vesc.lastRequest == request);
+        CHECK(poller.isSelective());
+        CHECK_EQ(poller.timeouts, 0);
+        CHECK(poller.replies >= 1000 / pollIntervalMs - 1);
+        const vescData_t &d = poller.data;
+        CHECK(fabsf(d.tempMosfet - 45.3f) < 0.01f);
+        CHECK(fabsf(d.tempMotor + 5.2f) < 0.01f);
+        CHECK(fabsf(d.avgInputCurrent + 5.67f) < 0.001f);
+        CHECK_EQ(d.rpm, 23456);
+        CHECK(fabsf(d.inpVoltage - 48.7f) < 0.01f);
+        CHECK(fabsf(d.ampHours - 1.2345f) < 0.0001f);
+        CHECK(fabsf(d.wattHours - 98.7654f) < 0.0001f);
+        CHECK_EQ(d.tachometerAbs, 99999);
+        CHECK_EQ(d.avgMotorCurrent, 0); // not asked for
+        CHECK_EQ(d.id, 0);
+        printf("selective,%u,%u,%u,%u\n", poller.requests, poller.replies, poller.timeouts, poller.badPackets);
+        printf("reply bytes,full %u,selective %u\n", (unsigned)FakeVesc::Payload(VESC_COMM_GET_VALUES, VESC_VALUES_ALL).size() + 5,
+               (unsigned)FakeVesc::Payload(VESC_COMM_GET_VALUES_SELECTIVE, mask).size() + 5);
+    }
+
+    // OLD FIRMWARE, no answer to the selective command: full values after VESC_SELECTIVE_MAX_MISSES timeouts
+    {
+        FakeVesc vesc;
+        vesc.answersSelective = false;
+        VescPoller poller;
+        poller.begin(vesc, pollIntervalMs, timeoutMs, mask);
+        while (poller.isSelective())
+        {
+            CHECK_EQ(poller.replies, 0);
+            poller.update();
+            hostAdvanceMicros(loopUs);
+        }
+        CHECK_EQ(poller.timeouts, VESC_SELECTIVE_MAX_MISSES);
+        Run(poller, 100);
+        CHECK_EQ(vesc.lastRequest[2], VESC_COMM_GET_VALUES);
+        CHECK(poller.replies > 0);
+        CheckFullValues(poller.data);
+        printf("fallback,%u,%u,%u,%u\n", poller.requests, poller.replies, poller.timeouts, poller.badPackets);
+    }
+
+    // BASELINE, the same second of host time through the blocking loop and through the poller. update() takes no host
+    // time, so the poller's loop runs at the loopUs the rest of loop() costs, the blocking one waits out every reply.
+    {
+        FakeVesc blockingVesc;
+        int blockingReplies;
+        int blockingIterations = RunBlocking(blockingVesc, 1000, blockingReplies);
+
+        FakeVesc vesc;
+        VescPoller poller;
+        poller.begin(vesc, pollIntervalMs, timeoutMs);
+        int iterations = 0;
+        for (unsigned long end = micros() + 1000000; micros() < end; hostAdvanceMicros(loopUs), iterations++)
+            poller.update();
+
+        CHECK(blockingReplies > 0);
+        CHECK(blockingReplies >= blockingIterations - 1);
+        CHECK(iterations > 100 * blockingIterations);
+        CHECK(poller.replies >= (uint32_t)blockingReplies);
+        printf("loop,iterations/s,replies/s\nblocking getVescValues,%d,%d\nVescPoller,%d,%u\n", blockingIterations,
+               blockingReplies, iterations, poller.replies);
+    }
+
+    return hostTestResult("vescPollerTest");
+}